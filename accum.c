@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Accumulation of full scene passes, via glAccum() or a float FBO.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "accum.h"
+#include "glcaps.h"
+#include "globjects.h"
+
+/*
+ * The FBO backends render each pass into scene (RGBA8 + depth), then add it
+ * into the float accum texture with one fullscreen quad using constant alpha
+ * blending, i.e. accum += weight * scene. AccumReturn() blits accum to the
+ * back buffer once per frame.
+ */
+struct AccumTargets
+{
+	enum AccumBackend backend;
+	GLuint width;
+	GLuint height;
+	GLuint sceneFbo;
+	GLuint sceneColor; /* texture */
+	GLuint sceneDepth; /* renderbuffer */
+	GLuint accumFbo;
+	GLuint accumColor; /* float texture */
+};
+
+static struct AccumTargets g_accum;
+
+static int FboSupported()
+{
+	if (GLVersionAtLeast(3, 0))
+		return 1;
+	return GLHasExtension("GL_ARB_framebuffer_object") &&
+			GLHasExtension("GL_ARB_texture_float");
+}
+
+static void DeleteTargets()
+{
+	if (g_accum.sceneFbo)
+		glDeleteFramebuffers(1, &g_accum.sceneFbo);
+	if (g_accum.accumFbo)
+		glDeleteFramebuffers(1, &g_accum.accumFbo);
+	if (g_accum.sceneDepth)
+		glDeleteRenderbuffers(1, &g_accum.sceneDepth);
+	if (g_accum.sceneColor)
+		glDeleteTextures(1, &g_accum.sceneColor);
+	if (g_accum.accumColor)
+		glDeleteTextures(1, &g_accum.accumColor);
+
+	g_accum.sceneFbo = 0;
+	g_accum.accumFbo = 0;
+	g_accum.sceneDepth = 0;
+	g_accum.sceneColor = 0;
+	g_accum.accumColor = 0;
+}
+
+/* Returns 0 on success, -1 if the framebuffers are incomplete */
+static int CreateTargets()
+{
+	GLint oldTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+
+	g_accum.sceneColor = GLCreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+			g_accum.width, g_accum.height, GL_NEAREST);
+	g_accum.accumColor = GLCreateTexture(
+			g_accum.backend == ACCUM_BACKEND_FBO32 ? GL_RGBA32F : GL_RGBA16F,
+			GL_RGBA, GL_FLOAT, g_accum.width, g_accum.height, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, oldTexture);
+
+	glGenRenderbuffers(1, &g_accum.sceneDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, g_accum.sceneDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
+			g_accum.width, g_accum.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	g_accum.sceneFbo = GLCreateFbo(g_accum.sceneColor, g_accum.sceneDepth);
+	GLenum sceneStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	g_accum.accumFbo = GLCreateFbo(g_accum.accumColor, 0);
+	GLenum accumStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (sceneStatus != GL_FRAMEBUFFER_COMPLETE ||
+		accumStatus != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("Warning: accumulation FBO incomplete (0x%x, 0x%x)\n",
+				sceneStatus, accumStatus);
+		DeleteTargets();
+		return -1;
+	}
+	return 0;
+}
+
+enum AccumBackend AccumInit(enum AccumBackend backend,
+		GLuint width, GLuint height)
+{
+	AccumCleanup();
+	g_accum.backend = backend;
+	g_accum.width = width;
+	g_accum.height = height;
+
+	if (backend == ACCUM_BACKEND_GL)
+		return backend;
+
+	if (!FboSupported())
+	{
+		printf("Warning: no float FBO support, falling back to glAccum()\n");
+		g_accum.backend = ACCUM_BACKEND_GL;
+		return g_accum.backend;
+	}
+
+	if (CreateTargets())
+		g_accum.backend = ACCUM_BACKEND_GL;
+
+	return g_accum.backend;
+}
+
+void AccumResize(GLuint width, GLuint height)
+{
+	if (width == g_accum.width && height == g_accum.height)
+		return;
+
+	g_accum.width = width;
+	g_accum.height = height;
+	if (g_accum.backend == ACCUM_BACKEND_GL)
+		return;
+
+	DeleteTargets();
+	if (CreateTargets())
+		g_accum.backend = ACCUM_BACKEND_GL;
+}
+
+void AccumClear()
+{
+	if (g_accum.backend == ACCUM_BACKEND_GL)
+	{
+		glClear(GL_ACCUM_BUFFER_BIT);
+		return;
+	}
+
+	glPushAttrib(GL_COLOR_BUFFER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_accum.accumFbo);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glPopAttrib();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, g_accum.sceneFbo);
+}
+
+void AccumResume()
+{
+	if (g_accum.backend == ACCUM_BACKEND_GL)
+		return;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, g_accum.sceneFbo);
+}
+
+/* accum = weight * scene + accumFactor * accum, one fullscreen quad */
+static void BlendScene(GLfloat weight, GLenum accumFactor)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, g_accum.accumFbo);
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT |
+			GL_TRANSFORM_BIT);
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendColor(0.0, 0.0, 0.0, weight);
+	glBlendFunc(GL_CONSTANT_ALPHA, accumFactor);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, g_accum.sceneColor);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0, 0.0); glVertex2f(-1.0, -1.0);
+	glTexCoord2f(1.0, 0.0); glVertex2f(1.0, -1.0);
+	glTexCoord2f(1.0, 1.0); glVertex2f(1.0, 1.0);
+	glTexCoord2f(0.0, 1.0); glVertex2f(-1.0, 1.0);
+	glEnd();
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+
+	glPopAttrib();
+	glBindFramebuffer(GL_FRAMEBUFFER, g_accum.sceneFbo);
+}
+
+void AccumAdd(GLfloat weight)
+{
+	if (g_accum.backend == ACCUM_BACKEND_GL)
+	{
+		glAccum(GL_ACCUM, weight);
+		return;
+	}
+
+	BlendScene(weight, GL_ONE);
+}
+
+void AccumMix(GLfloat weight)
+{
+	if (g_accum.backend == ACCUM_BACKEND_GL)
+	{
+		glAccum(GL_MULT, 1.0f - weight);
+		glAccum(GL_ACCUM, weight);
+		return;
+	}
+
+	BlendScene(weight, GL_ONE_MINUS_CONSTANT_ALPHA);
+}
+
+void AccumReturn()
+{
+	if (g_accum.backend == ACCUM_BACKEND_GL)
+	{
+		glAccum(GL_RETURN, 1.0);
+		return;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, g_accum.accumFbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, g_accum.width, g_accum.height,
+			0, 0, g_accum.width, g_accum.height,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+enum AccumBackend AccumGetBackend()
+{
+	return g_accum.backend;
+}
+
+const char* AccumBackendName(enum AccumBackend backend)
+{
+	switch (backend)
+	{
+		case ACCUM_BACKEND_GL:
+			return "glAccum";
+		case ACCUM_BACKEND_FBO16:
+			return "FBO RGBA16F";
+		case ACCUM_BACKEND_FBO32:
+			return "FBO RGBA32F";
+	}
+	return "unknown";
+}
+
+void AccumCleanup()
+{
+	DeleteTargets();
+}
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Accumulation of full scene passes, via glAccum() or a float FBO.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef ACCUM_H_
+#define ACCUM_H_
+
+#include <GL/gl.h>
+
+enum AccumBackend
+{
+  ACCUM_BACKEND_GL = 0, /* legacy glAccum(), needs GLUT_ACCUM */
+  ACCUM_BACKEND_FBO16, /* passes summed into an RGBA16F texture */
+  ACCUM_BACKEND_FBO32 /* passes summed into an RGBA32F texture */
+};
+
+/*
+ * Selects the backend for the current context. The FBO backends fall back
+ * to ACCUM_BACKEND_GL if framebuffer objects or float textures are not
+ * supported. Returns the backend actually in use.
+ */
+extern enum AccumBackend AccumInit(enum AccumBackend backend,
+		GLuint width, GLuint height);
+
+/* Must be called whenever the viewport size changes */
+extern void AccumResize(GLuint width, GLuint height);
+
+/*
+ * Replacement for glClear(GL_ACCUM_BUFFER_BIT). With an FBO backend this
+ * also redirects rendering to an offscreen scene target until AccumReturn().
+ */
+extern void AccumClear();
+
+/*
+ * Like AccumClear(), but keeps what was accumulated by earlier frames so
+ * passes can be added across several frames.
+ */
+extern void AccumResume();
+
+/* Replacement for glAccum(GL_ACCUM, weight) */
+extern void AccumAdd(GLfloat weight);
+
+/*
+ * accum = (1 - weight) * accum + weight * pass. Adding pass n with weight
+ * 1 / n keeps accum the mean of the passes so far.
+ */
+extern void AccumMix(GLfloat weight);
+
+/* Replacement for glAccum(GL_RETURN, 1.0), writes to the back buffer */
+extern void AccumReturn();
+
+extern enum AccumBackend AccumGetBackend();
+extern const char* AccumBackendName(enum AccumBackend backend);
+
+extern void AccumCleanup();
+
+#endif /* ACCUM_H_ */
@@ -0,0 +1,333 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Frame capture through a ring of pixel buffer objects and a writer thread.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "capture.h"
+#include "glcaps.h"
+
+/* Pixel buffers in the ring, frame n is read while frame n - 2 is mapped */
+#define CAPTURE_BUFFERS 3
+
+/* Frames the writer may fall behind by before frames are dropped */
+#define CAPTURE_QUEUE 8
+
+/*
+ * The queue is a single producer, single consumer ring of frame slots.
+ * The render thread only advances tail and the writer only advances head,
+ * so neither takes a lock. The semaphore just wakes the writer, posting
+ * it never blocks the render thread.
+ */
+static struct
+{
+	FILE* file;
+	const char* path;
+	enum CaptureFormat format;
+	GLuint width;
+	GLuint height;
+	GLuint fbo; /* 1 if framebuffer objects may be bound for reading */
+	size_t frameBytes; /* BGRA, bottom row first, as read */
+	GLuint buffers[CAPTURE_BUFFERS];
+	GLuint reads; /* frames read into buffers so far */
+	GLuint dropped;
+	GLubyte* slots[CAPTURE_QUEUE];
+	atomic_uint head; /* next slot the writer takes */
+	atomic_uint tail; /* next slot the render thread fills */
+	atomic_int stop;
+	sem_t ready; /* posted per queued frame, and once more to stop */
+	pthread_t writer;
+	GLuint written; /* writer only until joined */
+	GLuint failed;
+	GLubyte* out; /* writer scratch, a converted frame */
+} g_capture;
+
+enum CaptureFormat CaptureFormatFromPath(const char* path)
+{
+	const char* dot = strrchr(path, '.');
+	if (dot && 0 == strcasecmp(dot, ".ppm"))
+		return CAPTURE_FORMAT_PPM;
+	if (dot && 0 == strcasecmp(dot, ".y4m"))
+		return CAPTURE_FORMAT_Y4M;
+	return CAPTURE_FORMAT_RAW;
+}
+
+/* RGB24, top row first, as raw and PPM frames store it */
+static void ConvertRgb(const GLubyte* in, GLubyte* out)
+{
+	const GLuint w = g_capture.width;
+	for (GLuint y = 0; y < g_capture.height; ++y)
+	{
+		const GLubyte* row = in + 4 * (size_t) w * (g_capture.height - 1 - y);
+		for (GLuint x = 0; x < w; ++x, row += 4, out += 3)
+		{
+			out[0] = row[2];
+			out[1] = row[1];
+			out[2] = row[0];
+		}
+	}
+}
+
+/* Y, U and V planes, top row first, BT.601 studio range */
+static void ConvertYuv(const GLubyte* in, GLubyte* out)
+{
+	const size_t plane = (size_t) g_capture.width * g_capture.height;
+	GLubyte* yOut = out;
+	GLubyte* uOut = out + plane;
+	GLubyte* vOut = out + 2 * plane;
+	for (GLuint y = 0; y < g_capture.height; ++y)
+	{
+		const GLubyte* row = in + 4 * (size_t) g_capture.width *
+				(g_capture.height - 1 - y);
+		for (GLuint x = 0; x < g_capture.width; ++x, row += 4)
+		{
+			int b = row[0];
+			int g = row[1];
+			int r = row[2];
+			*yOut++ = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+			*uOut++ = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+			*vOut++ = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+		}
+	}
+}
+
+static int WriteFrame(const GLubyte* frame)
+{
+	FILE* f = g_capture.file;
+	const size_t pixels = (size_t) g_capture.width * g_capture.height;
+	switch (g_capture.format)
+	{
+		case CAPTURE_FORMAT_Y4M:
+			ConvertYuv(frame, g_capture.out);
+			return fputs("FRAME\n", f) < 0 ||
+					fwrite(g_capture.out, 3, pixels, f) != pixels;
+		case CAPTURE_FORMAT_PPM:
+			if (fprintf(f, "P6\n%u %u\n255\n", g_capture.width,
+					g_capture.height) < 0)
+				return 1;
+			/* fall through */
+		case CAPTURE_FORMAT_RAW:
+		default:
+			ConvertRgb(frame, g_capture.out);
+			return fwrite(g_capture.out, 3, pixels, f) != pixels;
+	}
+}
+
+static void* Writer(void* arg)
+{
+	(void) arg;
+	for (;;)
+	{
+		sem_wait(&g_capture.ready);
+		unsigned head = atomic_load_explicit(&g_capture.head,
+				memory_order_relaxed);
+		if (head == atomic_load_explicit(&g_capture.tail, memory_order_acquire))
+		{
+			if (atomic_load(&g_capture.stop))
+				break;
+			continue;
+		}
+
+		if (WriteFrame(g_capture.slots[head % CAPTURE_QUEUE]))
+			++g_capture.failed;
+		else
+			++g_capture.written;
+		atomic_store_explicit(&g_capture.head, head + 1, memory_order_release);
+	}
+	return 0;
+}
+
+static void FreeCapture()
+{
+	for (int i = 0; i < CAPTURE_QUEUE; ++i)
+	{
+		free(g_capture.slots[i]);
+		g_capture.slots[i] = 0;
+	}
+	free(g_capture.out);
+	g_capture.out = 0;
+	if (g_capture.buffers[0])
+		glDeleteBuffers(CAPTURE_BUFFERS, g_capture.buffers);
+	memset(g_capture.buffers, 0, sizeof(g_capture.buffers));
+	if (g_capture.file)
+		fclose(g_capture.file);
+	g_capture.file = 0;
+}
+
+int CaptureStart(const char* path, enum CaptureFormat format,
+		GLuint width, GLuint height, GLuint rateNum, GLuint rateDen)
+{
+	if (!GLVersionAtLeast(2, 1) &&
+			!GLHasExtension("GL_ARB_pixel_buffer_object"))
+	{
+		printf("Error: capture needs pixel buffer objects\n");
+		return -1;
+	}
+
+	memset(&g_capture, 0, sizeof(g_capture));
+	g_capture.file = fopen(path, "wb");
+	if (!g_capture.file)
+	{
+		printf("Error: cannot create %s\n", path);
+		return -1;
+	}
+	g_capture.path = path;
+	g_capture.format = format;
+	g_capture.width = width;
+	g_capture.height = height;
+	g_capture.fbo = GLVersionAtLeast(3, 0) ||
+			GLHasExtension("GL_ARB_framebuffer_object");
+	g_capture.frameBytes = 4 * (size_t) width * height;
+
+	GLuint ok = 1;
+	for (int i = 0; i < CAPTURE_QUEUE; ++i)
+	{
+		g_capture.slots[i] = malloc(g_capture.frameBytes);
+		ok = ok && g_capture.slots[i];
+	}
+	g_capture.out = malloc(3 * (size_t) width * height);
+	if (!ok || !g_capture.out)
+	{
+		printf("Error: out of memory for capture\n");
+		FreeCapture();
+		return -1;
+	}
+
+	glGenBuffers(CAPTURE_BUFFERS, g_capture.buffers);
+	for (int i = 0; i < CAPTURE_BUFFERS; ++i)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, g_capture.buffers[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, g_capture.frameBytes, 0,
+				GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (CAPTURE_FORMAT_Y4M == format)
+		fprintf(g_capture.file, "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C444\n",
+				width, height, rateNum, rateDen);
+
+	sem_init(&g_capture.ready, 0, 0);
+	if (pthread_create(&g_capture.writer, 0, Writer, 0))
+	{
+		printf("Error: cannot start the capture writer\n");
+		sem_destroy(&g_capture.ready);
+		FreeCapture();
+		return -1;
+	}
+	printf("Capture: %ux%u to %s\n", width, height, path);
+	return 0;
+}
+
+/*
+ * Copies buffer, read CAPTURE_BUFFERS - 1 frames ago, into the next free
+ * slot of the writer's queue. If the queue is full the frame is dropped,
+ * unless wait is set.
+ */
+static void Collect(GLuint buffer, GLuint wait)
+{
+	unsigned tail = atomic_load_explicit(&g_capture.tail, memory_order_relaxed);
+	while (tail - atomic_load_explicit(&g_capture.head, memory_order_acquire) >=
+			CAPTURE_QUEUE)
+	{
+		if (!wait)
+		{
+			++g_capture.dropped;
+			return;
+		}
+		usleep(1000);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	const GLubyte* pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (!pixels)
+	{
+		++g_capture.dropped;
+		return;
+	}
+	memcpy(g_capture.slots[tail % CAPTURE_QUEUE], pixels,
+			g_capture.frameBytes);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+	atomic_store_explicit(&g_capture.tail, tail + 1, memory_order_release);
+	sem_post(&g_capture.ready);
+}
+
+void CaptureFrame(const GLint viewport[4])
+{
+	if (!g_capture.file)
+		return;
+	if ((GLuint) viewport[2] != g_capture.width ||
+		(GLuint) viewport[3] != g_capture.height)
+	{
+		++g_capture.dropped;
+		return;
+	}
+
+	/* Offscreen effects may leave their framebuffer bound for reading */
+	GLint readFbo = 0;
+	if (g_capture.fbo)
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFbo);
+	if (readFbo)
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	/* BGRA is the layout drivers read back without converting */
+	GLuint n = g_capture.reads++;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER,
+			g_capture.buffers[n % CAPTURE_BUFFERS]);
+	glReadPixels(viewport[0], viewport[1], g_capture.width, g_capture.height,
+			GL_BGRA, GL_UNSIGNED_BYTE, 0);
+
+	if (n >= CAPTURE_BUFFERS - 1)
+		Collect(g_capture.buffers[(n + 1) % CAPTURE_BUFFERS], 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (readFbo)
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, readFbo);
+}
+
+void CaptureStop()
+{
+	if (!g_capture.file)
+		return;
+
+	GLuint first = g_capture.reads > CAPTURE_BUFFERS - 1 ?
+			g_capture.reads - (CAPTURE_BUFFERS - 1) : 0;
+	for (GLuint n = first; n < g_capture.reads; ++n)
+		Collect(g_capture.buffers[n % CAPTURE_BUFFERS], 1);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	atomic_store(&g_capture.stop, 1);
+	sem_post(&g_capture.ready);
+	pthread_join(g_capture.writer, 0);
+	sem_destroy(&g_capture.ready);
+
+	if (g_capture.failed)
+		printf("Error: %u frames could not be written to %s\n",
+				g_capture.failed, g_capture.path);
+	printf("Capture: %u frames written to %s, %u dropped\n",
+			g_capture.written, g_capture.path, g_capture.dropped);
+	FreeCapture();
+}
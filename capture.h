@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Frame capture through a ring of pixel buffer objects and a writer thread.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <GL/gl.h>
+
+enum CaptureFormat
+{
+  CAPTURE_FORMAT_RAW, /* RGB24, top row first, no headers */
+  CAPTURE_FORMAT_PPM, /* a binary PPM image per frame, one after another */
+  CAPTURE_FORMAT_Y4M /* YUV4MPEG2, 4:4:4 BT.601 studio range */
+};
+
+/* .ppm and .y4m by extension, anything else is raw */
+extern enum CaptureFormat CaptureFormatFromPath(const char* path);
+
+/*
+ * Creates path and starts the writer thread for width x height frames.
+ * The frame rate, rateNum / rateDen frames per second, only goes into the
+ * Y4M header. Needs a current context with pixel buffer objects. Returns 0
+ * on success, -1 on failure.
+ */
+extern int CaptureStart(const char* path, enum CaptureFormat format,
+		GLuint width, GLuint height, GLuint rateNum, GLuint rateDen);
+
+/*
+ * Call with the finished frame in the read buffer, before it is swapped.
+ * Starts reading it into the next pixel buffer of the ring, then hands the
+ * frame read two calls ago to the writer, which has had a frame to arrive.
+ * Never waits on the writer: a frame is dropped and counted if the
+ * writer's queue is full or the viewport is not the capture size.
+ */
+extern void CaptureFrame(const GLint viewport[4]);
+
+/*
+ * Hands over the frames still in flight, waits for the writer to finish
+ * and closes the file, then prints how many frames were written and
+ * dropped. Needs the context still current.
+ */
+extern void CaptureStop();
+
+#endif /* CAPTURE_H_ */
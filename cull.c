@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * View frustum culling of the sphere set.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "cull.h"
+
+static void SetPlane(GLfloat* plane, GLdouble x, GLdouble y, GLdouble z,
+		GLdouble w)
+{
+	GLdouble len = sqrt(x * x + y * y + z * z);
+	plane[0] = x / len;
+	plane[1] = y / len;
+	plane[2] = z / len;
+	plane[3] = w / len;
+}
+
+void FrustumFromBounds(struct Frustum* frustum,
+		GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
+		GLdouble near, GLdouble far)
+{
+	/* Side planes pass through the eye and the near plane window edges */
+	SetPlane(frustum->planes[0], near, 0.0, left, 0.0);
+	SetPlane(frustum->planes[1], -near, 0.0, -right, 0.0);
+	SetPlane(frustum->planes[2], 0.0, near, bottom, 0.0);
+	SetPlane(frustum->planes[3], 0.0, -near, -top, 0.0);
+	SetPlane(frustum->planes[4], 0.0, 0.0, -1.0, -near);
+	SetPlane(frustum->planes[5], 0.0, 0.0, 1.0, far);
+}
+
+void FrustumInclude(struct Frustum* frustum, const GLdouble point[3])
+{
+	for (int p = 0; p < 6; ++p)
+	{
+		GLfloat* plane = frustum->planes[p];
+		GLdouble d = plane[0] * point[0] + plane[1] * point[1] +
+				plane[2] * point[2] + plane[3];
+		if (d < 0.0)
+			plane[3] -= d;
+	}
+}
+
+static int Reserve(struct CullList* list, size_t count)
+{
+	if (count <= list->capacity)
+		return 0;
+
+	free(list->index);
+	list->index = malloc(sizeof(size_t) * count);
+	list->capacity = list->index ? count : 0;
+	list->count = 0;
+	return list->index ? 0 : -1;
+}
+
+int CullSpheres(const struct Frustum* frustum,
+		const struct Spheres* spheres, struct CullList* list)
+{
+	if (Reserve(list, spheres->count))
+		return -1;
+
+	size_t count = 0;
+	for (size_t i = 0; i < spheres->count; ++i)
+	{
+		GLfloat x = spheres->xOffset[i];
+		GLfloat y = -1.0f;
+		GLfloat z = spheres->zDrawn[i];
+		GLfloat r = spheres->radius[i];
+
+		int inside = 1;
+		for (int p = 0; inside && p < 6; ++p)
+		{
+			const GLfloat* plane = frustum->planes[p];
+			inside = plane[0] * x + plane[1] * y + plane[2] * z + plane[3] >= -r;
+		}
+
+		if (inside)
+			list->index[count++] = i;
+	}
+	list->count = count;
+	return 0;
+}
+
+int CullNone(const struct Spheres* spheres, struct CullList* list)
+{
+	if (Reserve(list, spheres->count))
+		return -1;
+	for (size_t i = 0; i < spheres->count; ++i)
+		list->index[i] = i;
+	list->count = spheres->count;
+	return 0;
+}
+
+void CullListFree(struct CullList* list)
+{
+	free(list->index);
+	list->index = 0;
+	list->count = 0;
+	list->capacity = 0;
+}
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * View frustum culling of the sphere set.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CULL_H_
+#define CULL_H_
+
+#include <stddef.h>
+
+#include <GL/gl.h>
+
+#include "spheres.h"
+
+/* Eye space planes, a point p is inside when dot(plane.xyz, p) + w >= 0 */
+struct Frustum
+{
+	GLfloat planes[6][4];
+};
+
+/* Indices of the spheres that survived culling, ascending */
+struct CullList
+{
+	size_t *index;
+	size_t count;
+	size_t capacity;
+};
+
+/* Same arguments as glFrustum() */
+extern void FrustumFromBounds(struct Frustum* frustum,
+		GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
+		GLdouble near, GLdouble far);
+
+/*
+ * Moves planes outward, keeping their normals, until point is inside.
+ * Including every corner of several frustums covers all of them, even
+ * when their apexes differ.
+ */
+extern void FrustumInclude(struct Frustum* frustum, const GLdouble point[3]);
+
+/*
+ * Fills list with every sphere whose bounding sphere is at least partly
+ * inside frustum. Sphere centers are at (xOffset, -1, zDrawn) in the
+ * space RenderSphere() draws in, before the pass's eye offset.
+ * Returns 0 on success, -1 if out of memory, list is empty then.
+ */
+extern int CullSpheres(const struct Frustum* frustum,
+		const struct Spheres* spheres, struct CullList* list);
+
+/* Puts every sphere in list, for when culling is disabled, see CullSpheres() */
+extern int CullNone(const struct Spheres* spheres, struct CullList* list);
+
+extern void CullListFree(struct CullList* list);
+
+#endif /* CULL_H_ */
@@ -0,0 +1,413 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Depth of field as a post process, blurring the frame by its depth buffer.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+#include <math.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "glcaps.h"
+#include "globjects.h"
+#include "dof.h"
+
+/*
+ * The depth pass renders into fbo's depth texture, then the finished frame
+ * is copied from the back buffer into its color texture. A setup pass
+ * shrinks both to half[0] at half size, color plus signed circle of
+ * confusion, which is blurred into half[1]. The composite mixes the sharp
+ * frame with it by the circle of confusion into the back buffer.
+ */
+struct DofTargets
+{
+	GLuint enabled;
+	GLuint width;
+	GLuint height;
+	GLuint fbo;
+	GLuint color; /* texture */
+	GLuint depth; /* depth texture */
+	GLuint halfFbo[2];
+	GLuint half[2]; /* half size textures, rgb and coc */
+	GLuint setup; /* programs */
+	GLuint blur;
+	GLuint composite;
+};
+
+static struct DofTargets g_dof;
+
+/* Taps of the blur disk, must match TAPS in the shader */
+#define TAPS 48
+
+/* Shared by every pass, the circle of confusion of a depth buffer value */
+static const char* g_cocShader =
+	"uniform vec2 planes;\n"
+	"uniform float focus;\n"
+	"uniform float aperture;\n"
+	"uniform float maxRadius;\n"
+	"float SignedCoc(float depth)\n"
+	"{\n"
+	"	float z = planes.x * planes.y /\n"
+	"			(planes.y - depth * (planes.y - planes.x));\n"
+	"	return clamp(aperture * (1.0 / focus - 1.0 / z),\n"
+	"			-maxRadius, maxRadius);\n"
+	"}\n";
+
+/*
+ * The circle of confusion is negative in front of the focus plane and
+ * grows with depth, so it also orders taps front to back. It is stored
+ * in alpha as 0 to 1 for -maxRadius to maxRadius.
+ */
+static const char* g_setupShader =
+	"uniform sampler2D scene;\n"
+	"uniform sampler2D depth;\n"
+	"uniform float maxRadius;\n"
+	"float SignedCoc(float depth);\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_TexCoord[0].xy;\n"
+	"	float coc = SignedCoc(texture2D(depth, uv).r);\n"
+	"	gl_FragColor = vec4(texture2D(scene, uv).rgb,\n"
+	"			0.5 + 0.5 * coc / maxRadius);\n"
+	"}\n";
+
+/*
+ * Scatter as gather: every tap of a disk of maxRadius is kept if its own
+ * circle of confusion reaches the center. Taps behind the center are
+ * limited to the center's circle, so a blurred background does not bleed
+ * over a sharp object in front of it, while a blurred foreground still
+ * spreads over what is behind. Alpha is how much blurred foreground
+ * covers the center.
+ */
+static const char* g_blurShader =
+	"uniform sampler2D source;\n"
+	"uniform vec2 texel;\n"
+	"uniform float maxRadius;\n"
+	"const int TAPS = 48;\n"
+	"uniform vec3 taps[TAPS];\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_TexCoord[0].xy;\n"
+	"	vec4 center = texture2D(source, uv);\n"
+	"	float coc = (center.a * 2.0 - 1.0) * maxRadius;\n"
+	"	vec3 sum = center.rgb;\n"
+	"	float total = 1.0;\n"
+	"	float front = 0.0;\n"
+	"	for (int i = 0; i < TAPS; ++i)\n"
+	"	{\n"
+	"		float r = maxRadius * taps[i].z;\n"
+	"		vec4 tap = texture2D(source, uv + taps[i].xy * maxRadius * texel);\n"
+	"		float tapCoc = (tap.a * 2.0 - 1.0) * maxRadius;\n"
+	"		float size = abs(tapCoc);\n"
+	"		if (tapCoc > coc)\n"
+	"			size = min(size, abs(coc));\n"
+	"		float weight = clamp(size - r + 1.0, 0.0, 1.0);\n"
+	"		if (tapCoc < coc)\n"
+	"			front = max(front, weight * clamp(size - 1.0, 0.0, 1.0));\n"
+	"		sum += tap.rgb * weight;\n"
+	"		total += weight;\n"
+	"	}\n"
+	"	gl_FragColor = vec4(sum / total, front);\n"
+	"}\n";
+
+static const char* g_compositeShader =
+	"uniform sampler2D scene;\n"
+	"uniform sampler2D depth;\n"
+	"uniform sampler2D blurred;\n"
+	"float SignedCoc(float depth);\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_TexCoord[0].xy;\n"
+	"	float coc = abs(SignedCoc(texture2D(depth, uv).r));\n"
+	"	vec4 blur = texture2D(blurred, uv);\n"
+	"	float weight = max(clamp(coc - 1.0, 0.0, 1.0), blur.a);\n"
+	"	gl_FragColor = vec4(mix(texture2D(scene, uv).rgb, blur.rgb, weight),\n"
+	"			1.0);\n"
+	"}\n";
+
+static int Supported()
+{
+	if (!GLVersionAtLeast(2, 0))
+		return 0;
+	if (GLVersionAtLeast(3, 0))
+		return 1;
+	return GLHasExtension("GL_ARB_framebuffer_object");
+}
+
+static void DeleteTargets()
+{
+	if (g_dof.fbo)
+		glDeleteFramebuffers(1, &g_dof.fbo);
+	if (g_dof.halfFbo[0])
+		glDeleteFramebuffers(2, g_dof.halfFbo);
+	if (g_dof.color)
+		glDeleteTextures(1, &g_dof.color);
+	if (g_dof.depth)
+		glDeleteTextures(1, &g_dof.depth);
+	if (g_dof.half[0])
+		glDeleteTextures(2, g_dof.half);
+	if (g_dof.setup)
+		glDeleteProgram(g_dof.setup);
+	if (g_dof.blur)
+		glDeleteProgram(g_dof.blur);
+	if (g_dof.composite)
+		glDeleteProgram(g_dof.composite);
+
+	g_dof.fbo = 0;
+	g_dof.halfFbo[0] = g_dof.halfFbo[1] = 0;
+	g_dof.color = 0;
+	g_dof.depth = 0;
+	g_dof.half[0] = g_dof.half[1] = 0;
+	g_dof.setup = 0;
+	g_dof.blur = 0;
+	g_dof.composite = 0;
+	g_dof.enabled = 0;
+}
+
+/*
+ * Links source with the circle of confusion shader and binds its
+ * samplers to units 0, 1 and 2 in order. Returns 0 if it does not build.
+ */
+static GLuint BuildProgram(const char* source, const char* name,
+		const char* samplers[3])
+{
+	char what[64];
+	snprintf(what, sizeof(what), "DOF %s", name);
+	const char* sources[2][2] = {
+		{ "#version 120\n", g_cocShader },
+		{ "#version 120\n", source }
+	};
+	GLuint shaders[2] = {
+		GLCompileShader(GL_FRAGMENT_SHADER, 2, sources[0], "DOF coc"),
+		GLCompileShader(GL_FRAGMENT_SHADER, 2, sources[1], what)
+	};
+	GLuint program = GLLinkProgram(shaders, 2, 0, 0, what);
+	if (!program)
+		return 0;
+
+	glUseProgram(program);
+	for (int i = 0; i < 3 && samplers[i]; ++i)
+		glUniform1i(glGetUniformLocation(program, samplers[i]), i);
+	glUseProgram(0);
+	return program;
+}
+
+/* Returns 0 on success, -1 if a shader does not build */
+static int CreatePrograms()
+{
+	const char* setup[3] = { "scene", "depth", 0 };
+	const char* blur[3] = { "source", 0, 0 };
+	const char* composite[3] = { "scene", "depth", "blurred" };
+	g_dof.setup = BuildProgram(g_setupShader, "setup", setup);
+	g_dof.blur = BuildProgram(g_blurShader, "blur", blur);
+	g_dof.composite = BuildProgram(g_compositeShader, "composite", composite);
+	if (!g_dof.setup || !g_dof.blur || !g_dof.composite)
+		return -1;
+
+	/* Golden angle spiral over the unit disk, x, y and radius */
+	GLfloat taps[TAPS][3];
+	for (int i = 0; i < TAPS; ++i)
+	{
+		GLfloat r = sqrtf((i + 0.5f) / TAPS);
+		GLfloat a = i * 2.39996323f;
+		taps[i][0] = r * cosf(a);
+		taps[i][1] = r * sinf(a);
+		taps[i][2] = r;
+	}
+	glUseProgram(g_dof.blur);
+	glUniform3fv(glGetUniformLocation(g_dof.blur, "taps"), TAPS, &taps[0][0]);
+	glUseProgram(0);
+	return 0;
+}
+
+/* Returns 0 on success, -1 if a framebuffer is incomplete */
+static int CreateTargets()
+{
+	GLint oldTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+	GLint oldFbo = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oldFbo);
+
+	/* The setup pass averages 2x2 texels, blur taps land between texels */
+	g_dof.color = GLCreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+			g_dof.width, g_dof.height, GL_LINEAR);
+	g_dof.depth = GLCreateTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT,
+			GL_UNSIGNED_INT, g_dof.width, g_dof.height, GL_NEAREST);
+	for (int i = 0; i < 2; ++i)
+		g_dof.half[i] = GLCreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+				(g_dof.width + 1) / 2, (g_dof.height + 1) / 2, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, oldTexture);
+
+	GLenum status[3];
+	g_dof.fbo = GLCreateFbo(g_dof.color, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+			GL_TEXTURE_2D, g_dof.depth, 0);
+	status[0] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	for (int i = 0; i < 2; ++i)
+	{
+		g_dof.halfFbo[i] = GLCreateFbo(g_dof.half[i], 0);
+		status[1 + i] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, oldFbo);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (status[i] != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("Warning: DOF FBO incomplete (0x%x)\n", status[i]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+GLuint DofConfigure(GLuint enable, GLuint width, GLuint height)
+{
+	if (!enable)
+	{
+		if (g_dof.enabled)
+			DeleteTargets();
+		return 0;
+	}
+
+	if (g_dof.enabled && width == g_dof.width && height == g_dof.height)
+		return 1;
+
+	DeleteTargets();
+	g_dof.width = width;
+	g_dof.height = height;
+
+	if (!Supported())
+	{
+		printf("Warning: post process DOF needs FBOs and GLSL\n");
+		return 0;
+	}
+
+	if (CreateTargets() || CreatePrograms())
+	{
+		DeleteTargets();
+		return 0;
+	}
+
+	g_dof.enabled = 1;
+	return 1;
+}
+
+void DofBeginDepth()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, g_dof.fbo);
+	glPushAttrib(GL_COLOR_BUFFER_BIT);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void DofEndDepth()
+{
+	glPopAttrib();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/* Covers the viewport, with texture coordinates 0 to 1 across it */
+static void DrawQuad()
+{
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0, 0.0); glVertex2f(-1.0, -1.0);
+	glTexCoord2f(1.0, 0.0); glVertex2f(1.0, -1.0);
+	glTexCoord2f(1.0, 1.0); glVertex2f(1.0, 1.0);
+	glTexCoord2f(0.0, 1.0); glVertex2f(-1.0, 1.0);
+	glEnd();
+}
+
+/*
+ * Binds program and sets its circle of confusion uniforms, scale converts
+ * pixels of the frame to pixels of the target drawn to.
+ */
+static void SetCoc(GLuint program, GLfloat near, GLfloat far, GLfloat focus,
+		GLfloat aperture, GLfloat maxRadius, GLfloat scale)
+{
+	glUseProgram(program);
+	glUniform2f(glGetUniformLocation(program, "planes"), near, far);
+	glUniform1f(glGetUniformLocation(program, "focus"), focus);
+	glUniform1f(glGetUniformLocation(program, "aperture"), aperture * scale);
+	glUniform1f(glGetUniformLocation(program, "maxRadius"), maxRadius * scale);
+}
+
+void DofApply(GLfloat near, GLfloat far, GLfloat focus,
+		GLfloat aperture, GLfloat maxRadius)
+{
+	const GLsizei halfWidth = (g_dof.width + 1) / 2;
+	const GLsizei halfHeight = (g_dof.height + 1) / 2;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_dof.fbo);
+	glBlitFramebuffer(0, 0, g_dof.width, g_dof.height,
+			0, 0, g_dof.width, g_dof.height,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_TRANSFORM_BIT |
+			GL_VIEWPORT_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	/* Frame and circle of confusion at half size */
+	glViewport(0, 0, halfWidth, halfHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_dof.halfFbo[0]);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, g_dof.depth);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, g_dof.color);
+	SetCoc(g_dof.setup, near, far, focus, aperture, maxRadius, 0.5f);
+	DrawQuad();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, g_dof.halfFbo[1]);
+	glBindTexture(GL_TEXTURE_2D, g_dof.half[0]);
+	SetCoc(g_dof.blur, near, far, focus, aperture, maxRadius, 0.5f);
+	glUniform2f(glGetUniformLocation(g_dof.blur, "texel"),
+			1.0f / halfWidth, 1.0f / halfHeight);
+	DrawQuad();
+
+	/* Sharp where in focus, blurred where not or covered by the foreground */
+	glViewport(0, 0, g_dof.width, g_dof.height);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, g_dof.half[1]);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, g_dof.color);
+	SetCoc(g_dof.composite, near, far, focus, aperture, maxRadius, 1.0f);
+	DrawQuad();
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+
+	glUseProgram(0);
+	glPopAttrib();
+}
+
+void DofCleanup()
+{
+	DeleteTargets();
+	g_dof.width = 0;
+	g_dof.height = 0;
+}
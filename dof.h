@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Depth of field as a post process, blurring the frame by its depth buffer.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef DOF_H_
+#define DOF_H_
+
+#include <GL/gl.h>
+
+/*
+ * (Re)creates the color and depth targets if post process DOF was just
+ * enabled or the size changed. Returns 1 if it is in use, 0 if disabled or
+ * depth textures and GLSL are not supported.
+ */
+extern GLuint DofConfigure(GLuint enable, GLuint width, GLuint height);
+
+/*
+ * Redirects rendering to the depth target, cleared, with color writes off.
+ * Draw the scene with the unjittered matrices, then call DofEndDepth().
+ */
+extern void DofBeginDepth();
+extern void DofEndDepth();
+
+/*
+ * Blurs the back buffer by the depth target and writes it back. A point at
+ * eye distance z is spread over a disk of radius
+ * aperture * |1 / z - 1 / focus| pixels, at most maxRadius. near and far
+ * are the planes of the depth pass projection.
+ */
+extern void DofApply(GLfloat near, GLfloat far, GLfloat focus,
+		GLfloat aperture, GLfloat maxRadius);
+
+extern void DofCleanup();
+
+#endif /* DOF_H_ */
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Queries for optional OpenGL features of the current context.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "glcaps.h"
+
+int GLVersionAtLeast(GLint major, GLint minor)
+{
+	const char* version = (const char*) glGetString(GL_VERSION);
+	GLint haveMajor = 0;
+	GLint haveMinor = 0;
+	if (!version || 2 != sscanf(version, "%d.%d", &haveMajor, &haveMinor))
+		return 0;
+
+	return haveMajor > major || (haveMajor == major && haveMinor >= minor);
+}
+
+int GLHasExtension(const char* name)
+{
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+	if (!extensions)
+		return 0;
+
+	/* Match whole, space separated names only */
+	size_t len = strlen(name);
+	for (const char* at = strstr(extensions, name); at;
+			at = strstr(at + len, name))
+	{
+		if ((at == extensions || at[-1] == ' ') &&
+			(at[len] == ' ' || at[len] == '\0'))
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Queries for optional OpenGL features of the current context.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef GLCAPS_H_
+#define GLCAPS_H_
+
+#include <GL/gl.h>
+
+/* 1 if the current context's GL_VERSION is at least major.minor */
+extern int GLVersionAtLeast(GLint major, GLint minor);
+
+/* 1 if name is in the current context's GL_EXTENSIONS string */
+extern int GLHasExtension(const char* name);
+
+#endif /* GLCAPS_H_ */
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Textures, framebuffers and shader programs for the offscreen effects.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "globjects.h"
+
+GLuint GLCreateTexture(GLint internalFormat, GLenum format, GLenum type,
+		GLsizei width, GLsizei height, GLint filter)
+{
+	GLuint tex = 0;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0,
+			format, type, 0);
+	return tex;
+}
+
+GLuint GLCreateFbo(GLuint color, GLuint depth)
+{
+	GLuint fbo = 0;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, color, 0);
+	if (depth)
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+				GL_RENDERBUFFER, depth);
+	return fbo;
+}
+
+GLuint GLCompileShader(GLenum type, GLsizei count, const char* const* source,
+		const char* what)
+{
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, count, (const GLchar**) source, 0);
+	glCompileShader(shader);
+
+	GLint ok = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok)
+	{
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), 0, log);
+		printf("Warning: %s shader failed to compile: %s\n", what, log);
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+GLuint GLLinkProgram(const GLuint* shaders, GLsizei count,
+		const char* const* attribs, GLuint attribCount, const char* what)
+{
+	GLuint compiled = 1;
+	for (GLsizei i = 0; i < count; ++i)
+		compiled = compiled && shaders[i];
+
+	GLuint program = 0;
+	if (compiled)
+	{
+		program = glCreateProgram();
+		for (GLsizei i = 0; i < count; ++i)
+			glAttachShader(program, shaders[i]);
+		for (GLuint i = 0; i < attribCount; ++i)
+		{
+			if (attribs[i])
+				glBindAttribLocation(program, i, attribs[i]);
+		}
+		glLinkProgram(program);
+	}
+
+	/* Attached shaders live on with the program */
+	for (GLsizei i = 0; i < count; ++i)
+		glDeleteShader(shaders[i]);
+	if (!program)
+		return 0;
+
+	GLint ok = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok)
+	{
+		char log[1024];
+		glGetProgramInfoLog(program, sizeof(log), 0, log);
+		printf("Warning: %s shader failed to link: %s\n", what, log);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Textures, framebuffers and shader programs for the offscreen effects.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef GLOBJECTS_H_
+#define GLOBJECTS_H_
+
+#include <GL/gl.h>
+
+/*
+ * Creates a width x height 2D texture without data, clamped to its edges
+ * and filtered by filter both ways. Leaves it bound to GL_TEXTURE_2D.
+ */
+extern GLuint GLCreateTexture(GLint internalFormat, GLenum format,
+		GLenum type, GLsizei width, GLsizei height, GLint filter);
+
+/*
+ * Creates a framebuffer drawing into the 2D texture color, with the
+ * renderbuffer depth as its depth buffer unless depth is 0. Leaves it
+ * bound to GL_FRAMEBUFFER, so its status can be checked.
+ */
+extern GLuint GLCreateFbo(GLuint color, GLuint depth);
+
+/*
+ * Compiles count strings of source, one after another, into a shader of
+ * type. Returns 0 and prints a warning naming it what if it fails.
+ */
+extern GLuint GLCompileShader(GLenum type, GLsizei count,
+		const char* const* source, const char* what);
+
+/*
+ * Links count shaders into a program and deletes them. Generic attribute
+ * i is bound to attribs[i] first, for each of the attribCount entries
+ * that is not 0. If a shader is 0, as GLCompileShader() returns on
+ * failure, nothing is linked. Returns 0 and prints a warning naming the
+ * program what if it does not link.
+ */
+extern GLuint GLLinkProgram(const GLuint* shaders, GLsizei count,
+		const char* const* attribs, GLuint attribCount, const char* what);
+
+#endif /* GLOBJECTS_H_ */
@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Offscreen EGL context for running the demo without a display server.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "headless.h"
+
+struct HeadlessContext
+{
+	EGLDisplay display;
+	EGLContext context;
+	EGLSurface surface;
+};
+
+static struct HeadlessContext g_egl = {
+		EGL_NO_DISPLAY, EGL_NO_CONTEXT, EGL_NO_SURFACE
+};
+
+static EGLDisplay GetDisplay()
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)
+			eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	/* Prefer surfaceless so we never touch X or DRM devices */
+	if (getPlatformDisplay)
+	{
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+				EGL_DEFAULT_DISPLAY, NULL);
+		if (display != EGL_NO_DISPLAY)
+			return display;
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+int HeadlessInit(GLuint width, GLuint height)
+{
+	g_egl.display = GetDisplay();
+	if (g_egl.display == EGL_NO_DISPLAY)
+	{
+		printf("Error: no EGL display available\n");
+		return -1;
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if (!eglInitialize(g_egl.display, &major, &minor))
+	{
+		printf("Error: eglInitialize failed (0x%x)\n", eglGetError());
+		return -1;
+	}
+
+	const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configs = 0;
+	if (!eglChooseConfig(g_egl.display, configAttribs, &config, 1, &configs) ||
+		0 == configs)
+	{
+		printf("Error: no EGL config with desktop GL and pbuffer support\n");
+		goto fail;
+	}
+
+	/* The fixed function pipeline needs desktop GL, not GLES */
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		printf("Error: eglBindAPI(EGL_OPENGL_API) failed\n");
+		goto fail;
+	}
+
+	g_egl.context = eglCreateContext(g_egl.display, config,
+			EGL_NO_CONTEXT, NULL);
+	if (g_egl.context == EGL_NO_CONTEXT)
+	{
+		printf("Error: eglCreateContext failed (0x%x)\n", eglGetError());
+		goto fail;
+	}
+
+	const EGLint surfaceAttribs[] = {
+			EGL_WIDTH, (EGLint) width,
+			EGL_HEIGHT, (EGLint) height,
+			EGL_NONE
+	};
+	g_egl.surface = eglCreatePbufferSurface(g_egl.display, config,
+			surfaceAttribs);
+	if (g_egl.surface == EGL_NO_SURFACE)
+	{
+		printf("Error: eglCreatePbufferSurface failed (0x%x)\n", eglGetError());
+		goto fail;
+	}
+
+	if (!eglMakeCurrent(g_egl.display, g_egl.surface, g_egl.surface,
+			g_egl.context))
+	{
+		printf("Error: eglMakeCurrent failed (0x%x)\n", eglGetError());
+		goto fail;
+	}
+
+	printf("Headless: EGL %d.%d, %s, OpenGL %s, %ux%u\n", major, minor,
+			glGetString(GL_RENDERER), glGetString(GL_VERSION),
+			width, height);
+	return 0;
+
+fail:
+	HeadlessCleanup();
+	return -1;
+}
+
+void HeadlessSwapBuffers()
+{
+	glFinish();
+}
+
+void HeadlessCleanup()
+{
+	if (g_egl.display == EGL_NO_DISPLAY)
+		return;
+
+	eglMakeCurrent(g_egl.display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			EGL_NO_CONTEXT);
+	if (g_egl.surface != EGL_NO_SURFACE)
+		eglDestroySurface(g_egl.display, g_egl.surface);
+	if (g_egl.context != EGL_NO_CONTEXT)
+		eglDestroyContext(g_egl.display, g_egl.context);
+	eglTerminate(g_egl.display);
+
+	g_egl.display = EGL_NO_DISPLAY;
+	g_egl.context = EGL_NO_CONTEXT;
+	g_egl.surface = EGL_NO_SURFACE;
+}
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Offscreen EGL context for running the demo without a display server.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+#include <GL/gl.h>
+
+/*
+ * Creates a desktop (compatibility profile) GL context on an EGL pbuffer of
+ * the given size using the surfaceless platform, so it works on llvmpipe
+ * without X or a GPU. Returns 0 on success, -1 on failure.
+ */
+extern int HeadlessInit(GLuint width, GLuint height);
+
+/* Pbuffers are single buffered; this waits for rendering to complete */
+extern void HeadlessSwapBuffers();
+
+extern void HeadlessCleanup();
+
+#endif /* HEADLESS_H_ */
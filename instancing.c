@@ -0,0 +1,348 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Instanced sphere rendering, one draw call for every sphere in a pass.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "glcaps.h"
+#include "globjects.h"
+#include "instancing.h"
+
+/* Generic attribute 0 aliases gl_Vertex, so instance data starts at 1 */
+#define ATTRIB_SPHERE 1
+#define ATTRIB_DIFFUSE 2
+#define ATTRIB_MOTION 3
+
+/* Floats per sphere in the instance buffer */
+#define INSTANCE_FLOATS 9
+
+/*
+ * Model transform of RenderSphere(): translate, roll about X, 90 degrees
+ * about Y, scale by radius. Lighting is evaluated per vertex into
+ * gl_FrontColor, so glShadeModel(GL_FLAT) still applies to it.
+ */
+static const char* g_vertexShader =
+	"#version 120\n"
+	"attribute vec4 sphere; /* xOffset, zDistance, roll degrees, radius */\n"
+	"attribute vec4 diffuse;\n"
+	"vec3 Orient(vec3 v, float c, float s)\n"
+	"{\n"
+	"	v = vec3(v.z, v.y, -v.x);\n"
+	"	return vec3(v.x, c * v.y - s * v.z, s * v.y + c * v.z);\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	float roll = radians(sphere.z);\n"
+	"	float c = cos(roll);\n"
+	"	float s = sin(roll);\n"
+	"	vec3 world = Orient(gl_Vertex.xyz, c, s) * sphere.w +\n"
+	"			vec3(sphere.x, -1.0, sphere.y);\n"
+	"	vec4 eye = gl_ModelViewMatrix * vec4(world, 1.0);\n"
+	"	vec3 N = normalize(gl_NormalMatrix * Orient(gl_Normal, c, s));\n"
+	"	vec3 L = normalize(gl_LightSource[0].position.xyz - eye.xyz);\n"
+	"	float NdotL = max(dot(N, L), 0.0);\n"
+	"	vec4 color = gl_FrontMaterial.emission +\n"
+	"			gl_LightModel.ambient * gl_FrontMaterial.ambient +\n"
+	"			gl_LightSource[0].ambient * gl_FrontMaterial.ambient +\n"
+	"			gl_LightSource[0].diffuse * diffuse * NdotL;\n"
+	"	if (NdotL > 0.0)\n"
+	"	{\n"
+	"		vec3 H = normalize(L + vec3(0.0, 0.0, 1.0));\n"
+	"		color += gl_LightSource[0].specular * gl_FrontMaterial.specular *\n"
+	"				pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess);\n"
+	"	}\n"
+	"	gl_FrontColor = vec4(color.rgb, diffuse.a);\n"
+	"	gl_Position = gl_ProjectionMatrix * eye;\n"
+	"}\n";
+
+static const char* g_fragmentShader =
+	"#version 120\n"
+	"void main()\n"
+	"{\n"
+	"	gl_FragColor = gl_Color;\n"
+	"}\n";
+
+/*
+ * Same placement, rasterized with the current (jittered) projection, but
+ * writes how far the surface moved on screen since the previous frame:
+ * both positions go through the unjittered projection, in texture units.
+ */
+static const char* g_motionVertexShader =
+	"#version 120\n"
+	"attribute vec4 sphere; /* xOffset, zDistance, roll degrees, radius */\n"
+	"attribute float motion; /* z travelled since the previous frame */\n"
+	"uniform mat4 unjittered;\n"
+	"varying vec4 now;\n"
+	"varying vec4 before;\n"
+	"vec3 Orient(vec3 v, float c, float s)\n"
+	"{\n"
+	"	v = vec3(v.z, v.y, -v.x);\n"
+	"	return vec3(v.x, c * v.y - s * v.z, s * v.y + c * v.z);\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	float roll = radians(sphere.z);\n"
+	"	vec3 world = Orient(gl_Vertex.xyz, cos(roll), sin(roll)) * sphere.w +\n"
+	"			vec3(sphere.x, -1.0, sphere.y);\n"
+	"	vec4 eye = gl_ModelViewMatrix * vec4(world, 1.0);\n"
+	"	now = unjittered * eye;\n"
+	"	before = unjittered * (gl_ModelViewMatrix *\n"
+	"			vec4(world - vec3(0.0, 0.0, motion), 1.0));\n"
+	"	gl_Position = gl_ProjectionMatrix * eye;\n"
+	"}\n";
+
+static const char* g_motionFragmentShader =
+	"#version 120\n"
+	"uniform float scale;\n"
+	"varying vec4 now;\n"
+	"varying vec4 before;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 moved = now.xy / now.w - before.xy / before.w;\n"
+	"	gl_FragColor = vec4(0.5 * scale * moved, 0.0, 1.0);\n"
+	"}\n";
+
+struct Instancing
+{
+	GLuint program;
+	GLuint motionProgram; /* 0 if it failed to build */
+	GLint unjittered; /* uniform locations in motionProgram */
+	GLint scale;
+	GLuint buffer;
+	GLfloat* staging; /* INSTANCE_FLOATS per sphere */
+	size_t capacity;
+	size_t count;
+	PFNGLVERTEXATTRIBDIVISORPROC vertexAttribDivisor;
+	PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced;
+};
+
+static struct Instancing g_inst;
+
+/* Names of the generic attributes, by the locations above */
+static const char* g_attribs[] = {
+	[ATTRIB_SPHERE] = "sphere",
+	[ATTRIB_DIFFUSE] = "diffuse",
+	[ATTRIB_MOTION] = "motion"
+};
+
+/* Returns the linked program, or 0 with a warning */
+static GLuint BuildProgram(const char* vertexSource,
+		const char* fragmentSource)
+{
+	GLuint shaders[2] = {
+		GLCompileShader(GL_VERTEX_SHADER, 1, &vertexSource, "sphere"),
+		GLCompileShader(GL_FRAGMENT_SHADER, 1, &fragmentSource, "sphere")
+	};
+	return GLLinkProgram(shaders, 2, g_attribs,
+			sizeof(g_attribs) / sizeof(g_attribs[0]), "sphere");
+}
+
+int InstancingInit()
+{
+	InstancingCleanup();
+
+	if (!GLVersionAtLeast(2, 0))
+		return -1;
+
+	/* Core in 3.3, otherwise the ARB entry points with the same signature */
+	if (GLVersionAtLeast(3, 3))
+	{
+		g_inst.vertexAttribDivisor = glVertexAttribDivisor;
+		g_inst.drawElementsInstanced = glDrawElementsInstanced;
+	}
+	else if (GLHasExtension("GL_ARB_instanced_arrays") &&
+			GLHasExtension("GL_ARB_draw_instanced"))
+	{
+		g_inst.vertexAttribDivisor = glVertexAttribDivisorARB;
+		g_inst.drawElementsInstanced = glDrawElementsInstancedARB;
+	}
+	else
+	{
+		return -1;
+	}
+
+	g_inst.program = BuildProgram(g_vertexShader, g_fragmentShader);
+	if (!g_inst.program)
+		return -1;
+
+	g_inst.motionProgram = BuildProgram(g_motionVertexShader,
+			g_motionFragmentShader);
+	if (g_inst.motionProgram)
+	{
+		g_inst.unjittered = glGetUniformLocation(g_inst.motionProgram,
+				"unjittered");
+		g_inst.scale = glGetUniformLocation(g_inst.motionProgram, "scale");
+	}
+
+	glGenBuffers(1, &g_inst.buffer);
+	return 0;
+}
+
+int InstancingUpdate(const struct Spheres* spheres,
+		const size_t* index, size_t count,
+		const GLfloat (*colors)[4], const GLfloat hitColor[4])
+{
+	if (count > g_inst.capacity)
+	{
+		free(g_inst.staging);
+		g_inst.capacity = count;
+		g_inst.staging = malloc(sizeof(GLfloat) * INSTANCE_FLOATS *
+				g_inst.capacity);
+		if (!g_inst.staging)
+		{
+			g_inst.capacity = 0;
+			g_inst.count = 0;
+			return -1;
+		}
+	}
+
+	GLfloat* out = g_inst.staging;
+	for (size_t n = 0; n < count; ++n)
+	{
+		size_t i = index[n];
+		const GLfloat* color = spheres->hit[i] ?
+				hitColor : colors[spheres->colorIdx[i]];
+		*out++ = spheres->xOffset[i];
+		*out++ = spheres->zDrawn[i];
+		*out++ = spheres->rotationDrawn[i];
+		*out++ = spheres->radius[i];
+		*out++ = color[0];
+		*out++ = color[1];
+		*out++ = color[2];
+		*out++ = color[3];
+		*out++ = spheres->zDrawn[i] - spheres->zDrawnLast[i];
+	}
+	g_inst.count = count;
+
+	/* Orphan the old storage so a pass still reading it does not stall us */
+	glBindBuffer(GL_ARRAY_BUFFER, g_inst.buffer);
+	glBufferData(GL_ARRAY_BUFFER,
+			sizeof(GLfloat) * INSTANCE_FLOATS * g_inst.count,
+			g_inst.staging, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return 0;
+}
+
+void InstancingDraw(const struct SphereMesh* mesh, size_t first,
+		size_t count)
+{
+	if (0 == count || first + count > g_inst.count)
+		return;
+
+	/* Offsetting the attributes avoids needing GL 4.2 base instances */
+	const GLsizei stride = sizeof(GLfloat) * INSTANCE_FLOATS;
+
+	glUseProgram(g_inst.program);
+
+	glBindBuffer(GL_ARRAY_BUFFER, g_inst.buffer);
+	glEnableVertexAttribArray(ATTRIB_SPHERE);
+	glEnableVertexAttribArray(ATTRIB_DIFFUSE);
+	glVertexAttribPointer(ATTRIB_SPHERE, 4, GL_FLOAT, GL_FALSE,
+			stride, (const GLvoid*) (stride * first));
+	glVertexAttribPointer(ATTRIB_DIFFUSE, 4, GL_FLOAT, GL_FALSE,
+			stride, (const GLvoid*) (stride * first + sizeof(GLfloat) * 4));
+	g_inst.vertexAttribDivisor(ATTRIB_SPHERE, 1);
+	g_inst.vertexAttribDivisor(ATTRIB_DIFFUSE, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, 0);
+	glNormalPointer(GL_FLOAT, 0, 0);
+
+	g_inst.drawElementsInstanced(GL_TRIANGLES, mesh->indexCount,
+			GL_UNSIGNED_SHORT, 0, count);
+
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	g_inst.vertexAttribDivisor(ATTRIB_SPHERE, 0);
+	g_inst.vertexAttribDivisor(ATTRIB_DIFFUSE, 0);
+	glDisableVertexAttribArray(ATTRIB_SPHERE);
+	glDisableVertexAttribArray(ATTRIB_DIFFUSE);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(0);
+}
+
+int InstancingMotionSupported()
+{
+	return g_inst.motionProgram != 0;
+}
+
+void InstancingDrawMotion(const struct SphereMesh* mesh, size_t first,
+		size_t count, const GLfloat unjittered[16], GLfloat scale)
+{
+	if (0 == count || first + count > g_inst.count || !g_inst.motionProgram)
+		return;
+
+	const GLsizei stride = sizeof(GLfloat) * INSTANCE_FLOATS;
+
+	glUseProgram(g_inst.motionProgram);
+	glUniformMatrix4fv(g_inst.unjittered, 1, GL_FALSE, unjittered);
+	glUniform1f(g_inst.scale, scale);
+
+	glBindBuffer(GL_ARRAY_BUFFER, g_inst.buffer);
+	glEnableVertexAttribArray(ATTRIB_SPHERE);
+	glEnableVertexAttribArray(ATTRIB_MOTION);
+	glVertexAttribPointer(ATTRIB_SPHERE, 4, GL_FLOAT, GL_FALSE,
+			stride, (const GLvoid*) (stride * first));
+	glVertexAttribPointer(ATTRIB_MOTION, 1, GL_FLOAT, GL_FALSE,
+			stride, (const GLvoid*) (stride * first + sizeof(GLfloat) * 8));
+	g_inst.vertexAttribDivisor(ATTRIB_SPHERE, 1);
+	g_inst.vertexAttribDivisor(ATTRIB_MOTION, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, 0);
+
+	g_inst.drawElementsInstanced(GL_TRIANGLES, mesh->indexCount,
+			GL_UNSIGNED_SHORT, 0, count);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	g_inst.vertexAttribDivisor(ATTRIB_SPHERE, 0);
+	g_inst.vertexAttribDivisor(ATTRIB_MOTION, 0);
+	glDisableVertexAttribArray(ATTRIB_SPHERE);
+	glDisableVertexAttribArray(ATTRIB_MOTION);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(0);
+}
+
+void InstancingCleanup()
+{
+	if (g_inst.program)
+		glDeleteProgram(g_inst.program);
+	if (g_inst.motionProgram)
+		glDeleteProgram(g_inst.motionProgram);
+	if (g_inst.buffer)
+		glDeleteBuffers(1, &g_inst.buffer);
+	free(g_inst.staging);
+
+	g_inst.program = 0;
+	g_inst.motionProgram = 0;
+	g_inst.buffer = 0;
+	g_inst.staging = 0;
+	g_inst.capacity = 0;
+	g_inst.count = 0;
+}
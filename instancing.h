@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Instanced sphere rendering, one draw call for every sphere in a pass.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef INSTANCING_H_
+#define INSTANCING_H_
+
+#include <GL/gl.h>
+
+#include "spheremesh.h"
+#include "spheres.h"
+
+/*
+ * Compiles the GLSL 1.20 sphere shader. Returns 0 on success, -1 if shaders
+ * or instanced arrays are not supported by the current context.
+ */
+extern int InstancingInit();
+
+/*
+ * Packs translation, roll, radius, diffuse color and z motion of the count
+ * spheres listed in index into the instance buffer. Call once per frame, and again
+ * whenever spheres move between passes. Hit spheres use hitColor.
+ * Returns 0 on success, -1 if out of memory, nothing is drawn then.
+ */
+extern int InstancingUpdate(const struct Spheres* spheres,
+		const size_t* index, size_t count,
+		const GLfloat (*colors)[4], const GLfloat hitColor[4]);
+
+/*
+ * Draws count spheres from the last InstancingUpdate(), starting at its
+ * first, with the current projection and modelview, lit like the fixed
+ * function pipeline does with GL_LIGHT0 and the GL_FRONT material.
+ */
+extern void InstancingDraw(const struct SphereMesh* mesh, size_t first,
+		size_t count);
+
+/* 1 if InstancingInit() also built the motion vector shader */
+extern int InstancingMotionSupported();
+
+/*
+ * Draws the same spheres as InstancingDraw(), rasterized with the current
+ * projection, but writes each pixel's screen motion since the previous
+ * frame (zDrawn - zDrawnLast) into red and green, in texture coordinate
+ * units. unjittered is the column major projection the motion is
+ * measured with. The motion is multiplied by scale, so with zDrawnLast
+ * holding where spheres are going rather than where they were, -1 gives
+ * the motion forward from where they are drawn.
+ */
+extern void InstancingDrawMotion(const struct SphereMesh* mesh, size_t first,
+		size_t count, const GLfloat unjittered[16], GLfloat scale);
+
+extern void InstancingCleanup();
+
+#endif /* INSTANCING_H_ */
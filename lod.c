@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Screen space error driven level of detail for the spheres.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lod.h"
+
+/* Must stay below the level above for the hysteresis band to exist */
+#define LOD_HYSTERESIS 0.5f
+
+/*
+ * Stacks step through pi and slices through 2 pi, so half as many stacks
+ * give the same worst case silhouette error as the slices.
+ */
+static const GLint g_tessellation[LOD_LEVELS][2] =
+{
+	{ 24, 24 },
+	{ 16, 8 },
+	{ 10, 5 },
+	{ 6, 3 },
+};
+
+/* Error of each level as a fraction of the projected radius */
+static GLfloat g_relError[LOD_LEVELS];
+
+static size_t* g_scratch;
+static size_t g_capacity;
+
+static void InitRelError()
+{
+	if (g_relError[LOD_LEVELS - 1] > 0.0f)
+		return;
+
+	/* A chord of angle 2 pi / slices sags r * (1 - cos(pi / slices)) */
+	for (GLint level = 0; level < LOD_LEVELS; ++level)
+		g_relError[level] = 1.0f - cosf(M_PI / g_tessellation[level][0]);
+}
+
+static GLint PickLevel(GLint level, GLfloat pixels, GLfloat maxError)
+{
+	if (level < 0 || level >= LOD_LEVELS)
+		level = 0;
+
+	while (level > 0 && g_relError[level] * pixels > maxError)
+		--level;
+	while (level < LOD_LEVELS - 1 &&
+			g_relError[level + 1] * pixels < maxError * LOD_HYSTERESIS)
+		++level;
+
+	return level;
+}
+
+int LodSelect(struct Spheres* spheres, size_t* index, size_t count,
+		GLfloat pixelsPerUnit, GLfloat maxError, struct LodBatches* batches)
+{
+	InitRelError();
+	memset(batches, 0, sizeof(*batches));
+
+	int ret = 0;
+	if (maxError > 0.0f && count > g_capacity)
+	{
+		free(g_scratch);
+		g_scratch = malloc(sizeof(size_t) * count);
+		g_capacity = g_scratch ? count : 0;
+		if (!g_scratch)
+			ret = -1;
+	}
+
+	/* Without scratch to sort in, every sphere stays at full detail */
+	if (maxError <= 0.0f || ret || 0 == count)
+	{
+		for (size_t n = 0; n < count; ++n)
+			spheres->lod[index[n]] = 0;
+		batches->count[0] = count;
+		return ret;
+	}
+
+	for (size_t n = 0; n < count; ++n)
+	{
+		size_t i = index[n];
+
+		/* Same center as CullSpheres(), eye at the origin */
+		GLfloat x = spheres->xOffset[i];
+		GLfloat z = spheres->zDrawn[i];
+		GLfloat dist = sqrtf(x * x + 1.0f + z * z);
+		GLfloat pixels = dist > spheres->radius[i] ?
+				spheres->radius[i] * pixelsPerUnit / dist : INFINITY;
+		GLint level = PickLevel(spheres->lod[i], pixels, maxError);
+		spheres->lod[i] = level;
+		++batches->count[level];
+	}
+
+	for (GLint level = 1; level < LOD_LEVELS; ++level)
+		batches->first[level] = batches->first[level - 1] +
+				batches->count[level - 1];
+
+	/* Counting sort, stable so each run stays ascending */
+	size_t next[LOD_LEVELS];
+	memcpy(next, batches->first, sizeof(next));
+	for (size_t n = 0; n < count; ++n)
+		g_scratch[next[spheres->lod[index[n]]]++] = index[n];
+	memcpy(index, g_scratch, sizeof(size_t) * count);
+	return 0;
+}
+
+const struct SphereMesh* LodMesh(GLint level)
+{
+	return SphereMeshGet(g_tessellation[level][0], g_tessellation[level][1]);
+}
+
+void LodTessellation(GLint level, GLint* slices, GLint* stacks)
+{
+	*slices = g_tessellation[level][0];
+	*stacks = g_tessellation[level][1];
+}
+
+GLsizei LodTriangles(GLint level)
+{
+	return LodMesh(level)->indexCount / 3;
+}
+
+void LodCleanup()
+{
+	free(g_scratch);
+	g_scratch = 0;
+	g_capacity = 0;
+}
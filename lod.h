@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Screen space error driven level of detail for the spheres.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef LOD_H_
+#define LOD_H_
+
+#include <stddef.h>
+
+#include <GL/gl.h>
+
+#include "spheremesh.h"
+#include "spheres.h"
+
+/* Level 0 is the full 24x24 mesh, each level after it is coarser */
+#define LOD_LEVELS 4
+
+/* Visible spheres grouped by level, see LodSelect() */
+struct LodBatches
+{
+  size_t first[LOD_LEVELS]; /* offset of the level's run in the index list */
+  size_t count[LOD_LEVELS];
+};
+
+/*
+ * Updates spheres->lod for the count spheres listed in index, then reorders
+ * index so every level is one contiguous run, ascending within a run.
+ * pixelsPerUnit is the viewport height over 2 * tan(fov / 2), so a sphere
+ * of radius r at eye distance d covers r * pixelsPerUnit / d pixels.
+ * maxError is the allowed silhouette error in pixels, 0 keeps every sphere
+ * at level 0. A sphere only drops to a coarser level once that level is
+ * well under maxError, so spheres near a threshold do not pop back and forth.
+ * Returns 0 on success, or -1 if out of memory, with every sphere at level 0.
+ */
+extern int LodSelect(struct Spheres* spheres, size_t* index, size_t count,
+		GLfloat pixelsPerUnit, GLfloat maxError, struct LodBatches* batches);
+
+/* Mesh for a level, 0 if out of memory. Needs a current context */
+extern const struct SphereMesh* LodMesh(GLint level);
+
+/* Tessellation of a level's mesh, no context needed */
+extern void LodTessellation(GLint level, GLint* slices, GLint* stacks);
+
+/* Triangles drawn per sphere at a level */
+extern GLsizei LodTriangles(GLint level);
+
+extern void LodCleanup();
+
+#endif /* LOD_H_ */
@@ -23,14 +23,36 @@
 #include <string.h>
 #include <unistd.h>
 #include <assert.h>
+#include <getopt.h>
 
 #include <GL/gl.h>
+#include <GL/glu.h>
 #include <GL/glut.h>
 
+#ifdef HAVE_EGL
+#include "headless.h"
+#endif
+
+#include "accum.h"
+#include "glcaps.h"
+#include "msaa.h"
+#include "spheremesh.h"
+#include "spheres.h"
+#include "instancing.h"
+#include "cull.h"
+#include "lod.h"
+#include "threadpool.h"
+#include "pick.h"
+#include "taa.h"
+#include "sampler.h"
+#include "dof.h"
+#include "motionblur.h"
+#include "softraster.h"
+#include "capture.h"
+
 /* Redbook includes (see ./subprojects/) */
 #include "accpersp.h"
 #include "checker.h"
-#include "jitter.h"
 
 static const GLfloat g_colors[][4] = {
 		{ 0.7, 0.7, 0.0, 1.0 },
@@ -45,37 +67,99 @@ static const char* g_colorNames[] = {
 /* the color of warp 9 */
 static const GLfloat g_red[4] = { 0.7, 0.0, 0.0, 1.0 };
 
+/* Set up by InitGL(), the software renderer lights spheres the same way */
+static const struct SoftLighting g_lighting = {
+		.position = { 0.0, 20.0, 0.0, 1.0 },
+		.modelAmbient = { 0.2, 0.2, 0.2, 1.0 },
+		.ambient = { 1.0, 1.0, 1.0, 1.0 },
+		.specular = { 1.0, 1.0, 1.0, 1.0 },
+		.shininess = 50.0
+};
+
+/* Floor corners: s and t in texture repeats, then x, y, z */
+static const GLfloat g_floorQuad[4][5] = {
+		{ 0.0, 0.0, -5.0, -2.0, -50.0 },
+		{ 0.0, 1.0, -5.0, -2.0, 1.0 },
+		{ 1.0, 1.0, 5.0, -2.0, 1.0 },
+		{ 1.0, 0.0, 5.0, -2.0, -50.0 }
+};
+
 static const GLint g_fpsTarget = 40;
 
 struct UserSettings
 {
-  GLuint enableAA; /* 0 if disabled, a jitter index from jitter.h otherwise */
+  GLuint enableAA; /* 0 if disabled, jitter samples per frame otherwise */
+  GLuint msaa; /* 0 if disabled, multisample count otherwise, replaces AA jitter */
   GLuint enableDOF; /* 0 if disabled, 1-250 otherwise */
   GLuint enableBlur; /* count of frames to motion blur on hit */
   GLuint debug; /* 1 if enabled */
   GLfloat fovAngle;
   GLuint hitDuration; /* time in milliseconds that hits are reported */
   GLuint focus;
-};
-
-struct Sphere
-{
-  GLuint hit; /* if 1 glut reports a GL_PROJECTION hit */
-  GLfloat zDistance;
-  GLfloat rotation; /* X rotation (roll effect) */
-  GLint colorIdx; /* see g_colors[] */
-  GLint glName; /* unique id for glPushName */
-  GLfloat zSpeed; /* How fast to move on Z */
-  GLfloat zSpeedDefault;
-  GLfloat radius;
-  GLfloat xOffset;
+  GLuint instancing; /* 1 to draw all spheres with one instanced call */
+  GLuint culling; /* 1 to skip spheres outside the view frustum */
+  GLfloat lodError; /* allowed sphere silhouette error in pixels, 0 disables LOD */
+  GLuint progressive; /* jitter passes per frame when refining across frames, 0 for all */
+  GLuint governor; /* 1 to lower the jitter sample count to hold g_fpsTarget */
+  GLuint taa; /* 1 for temporal AA, one jittered pass per frame, replaces AA jitter */
+  GLuint dofPost; /* 1 to blur DOF by the depth buffer instead of jittering the eye */
+  GLuint blurPost; /* 1 to motion blur along screen velocity instead of re-rendering */
 };
 
 struct State
 {
+  GLuint instancingSupported; /* set by InitGL() */
+  GLuint msaa; /* samples MSAA renders with after clamping, 0 if off */
   GLuint fps;
   GLuint baseTime;
   GLuint framesRendered; /* does not include motion blur or jitter frames */
+  GLuint clock; /* simulated milliseconds, only used when headless */
+  GLuint passes; /* full scene renders, including jitter and blur passes */
+  GLuint simTime; /* time of the last simulation tick, in milliseconds */
+  GLfloat simAlpha; /* how far the frame is into the next tick, 0 to 1 */
+  GLuint paused; /* 1 while the simulation clock is stopped */
+  GLuint jitterSamples; /* passes of the last jitter loop, after the governor */
+  GLfloat passMs; /* governor: smoothed wall time per pass, 0 until measured */
+  double frameStartMs; /* governor: wall time this frame started */
+  GLuint framePasses; /* governor: g_state.passes when this frame started */
+  GLuint taaFrame; /* TAA frames rendered, picks the jitter sample */
+  GLfloat taaFovAngle; /* fovAngle the TAA history was rendered with */
+  GLuint dofPost; /* 1 if this frame gets post process DOF, see PresentFrame() */
+  GLuint blurPost; /* 1 if this frame gets post process motion blur */
+};
+
+/* Running accumulation of the jitter loop, kept across frames */
+struct Progressive
+{
+	GLuint samples; /* jitter passes accumulated so far, 0 forces a restart */
+	GLuint jitterMax; /* passes the accumulation is complete at */
+	struct UserSettings settings; /* settings the accumulation was made with */
+	GLint viewport[4];
+	GLfloat simAlpha;
+};
+
+/* TAA cycles through the jitter set of this size, one sample a frame */
+#define TAA_SAMPLES 8
+/* Weight of the new frame in the TAA history */
+#define TAA_BLEND 0.1f
+
+/*
+ * Lens radius of post process DOF, in eye space units. The jitter loop
+ * moves the eye by up to 0.33 * half a pixel of jitter, this matches it.
+ */
+#define DOF_APERTURE 0.165f
+/* Largest post process DOF blur radius, as a fraction of viewport height */
+#define DOF_MAX_RADIUS 0.05f
+
+/* Texels across the floor, makeCheckImage() repeats every 16 of them */
+#define FLOOR_WIDTH 512
+#define FLOOR_HEIGHT 1024
+#define FLOOR_TILE 16
+
+enum FloorMode
+{
+	FLOOR_MODE_TILE, /* one mipmapped 16x16 luminance tile, repeated */
+	FLOOR_MODE_IMAGE /* the original 512x1024 RGBA image, GL_NEAREST */
 };
 
 struct CheckerboardFloor
@@ -83,21 +167,69 @@ struct CheckerboardFloor
 	GLuint texName;
 	GLuint width;
 	GLuint height;
-	GLubyte *image;
+	GLubyte *image; /* freed once uploaded */
+	enum CheckImageFormat format;
+	GLfloat repeatS; /* texture repeats across the floor */
+	GLfloat repeatT;
+};
+
+struct RunOptions
+{
+  GLuint headless; /* 1 to render offscreen without GLUT */
+  GLuint width;
+  GLuint height;
+  GLuint frames; /* headless: frames to render before exiting */
+  GLuint timeStep; /* headless: simulated milliseconds per frame */
+  GLuint warmup; /* headless: untimed frames rendered first */
+  GLuint hitInterval; /* headless: hit every sphere this often, 0 never */
+  size_t sphereCount;
+  GLuint seeded; /* 1 if seed should be used instead of /dev/urandom */
+  GLuint seed;
+  enum AccumBackend accumBackend; /* requested, AccumInit() may fall back */
+  GLuint threads; /* simulation and software renderer threads, 0 per CPU */
+  enum FloorMode floorMode;
+  GLuint anisotropy; /* tile floor filtering limit, 1 for none */
+  GLuint software; /* 1 to rasterize on the CPU, GL only shows the result */
+  const char* capturePath; /* file every presented frame is written to, or 0 */
 };
 
+static struct UserSettings g_defaultSettings = {
+		.fovAngle = 50.0,
+		.hitDuration = 500, /* millisec */
+		.instancing = 1,
+		.culling = 1,
+		.lodError = 1.0
+};
+static struct RunOptions g_options = {
+		.width = 1024,
+		.height = 1024,
+		.frames = 100,
+		.sphereCount = 2,
+		.anisotropy = 8,
+		.accumBackend = ACCUM_BACKEND_FBO16
+};
 static struct UserSettings g_userSettings;
-static struct Sphere g_spheres[2];
+static struct Spheres g_spheres;
 static struct State g_state;
 static struct CheckerboardFloor g_floor;
+static struct Frustum g_frustum; /* union of this frame's pass frustums */
+static struct CullList g_visible; /* spheres drawn by every pass */
+static GLfloat g_pixelsPerUnit; /* projected size scale, set with g_frustum */
+static accMatrixCache g_jitterMatrices; /* per pass matrices of the jitter loop */
+static struct Progressive g_progressive;
+static struct LodBatches g_lod; /* runs of g_visible per level of detail */
+static struct PickGrid g_pickGrid; /* rebuilt on every click */
 
 static unsigned int RandomInt1to20()
 {
 	static int didSrand = 0;
-	if (didSrand)
+	static FILE* handle = 0;
+	if (didSrand || g_options.seeded)
 		goto srand;
 
-	FILE* handle = fopen("/dev/urandom", "r");
+	/* Kept open, ResetData() may ask for millions of these */
+	if (!handle)
+		handle = fopen("/dev/urandom", "r");
 	if(!handle)
 		goto srand;
 
@@ -116,8 +248,15 @@ static unsigned int RandomInt1to20()
 srand:
 	if (!didSrand)
 	{
-		printf("Warning: using rand() instead of /dev/urandom\n");
-		srand(time(NULL));
+		if (g_options.seeded)
+		{
+			srand(g_options.seed);
+		}
+		else
+		{
+			printf("Warning: using rand() instead of /dev/urandom\n");
+			srand(time(NULL));
+		}
 		didSrand = 1;
 	}
 
@@ -127,39 +266,80 @@ out:
 	return (random % 20) + 1;
 }
 
+/* Wall clock, even when headless runs on a simulated clock */
+static double NowMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+/* Milliseconds since start, simulated when running headless */
+static GLuint ElapsedTime()
+{
+	if (g_options.headless)
+		return g_state.clock;
+	return glutGet(GLUT_ELAPSED_TIME);
+}
+
+
 static void ResetData()
 {
-	/* User settings */
-	memset(&g_userSettings, 0, sizeof(g_userSettings));
-	g_userSettings.fovAngle = 50.0;
-	g_userSettings.hitDuration = 500; /* millisec */
+	/* User settings, defaults may be overridden on the command line */
+	g_userSettings = g_defaultSettings;
 
 	/* Program state */
+	GLuint instancingSupported = g_state.instancingSupported;
 	memset(&g_state, 0, sizeof(g_state));
+	g_state.instancingSupported = instancingSupported;
+	g_state.simTime = ElapsedTime();
+	g_progressive.samples = 0;
+	TaaReset();
 
 	/* Spheres */
-	memset(&g_spheres, 0, sizeof(g_spheres));
+	if (SpheresAlloc(&g_spheres, g_options.sphereCount))
+	{
+		printf("Error: cannot allocate %zu spheres\n", g_options.sphereCount);
+		exit(1);
+	}
 
-	/* TODO make dynamic to support n>2 spheres */
-	g_spheres[0].xOffset = -2.0;
-	g_spheres[1].xOffset = 2.0;
+	/*
+	 * 2 lanes at the original x = -2, 2, or 4 lanes for 4+ spheres. There is
+	 * no center lane, spheres wrap to z = 0 and would swallow the camera.
+	 * Rows of spheres are spread out along the track.
+	 */
+	size_t lanes = g_spheres.count < 4 ? 2 : 4;
+	size_t rows = (g_spheres.count + lanes - 1) / lanes;
+	GLfloat laneWidth = 8.0f / lanes;
 
-	for (int i = 0; i < sizeof(g_spheres) / sizeof(g_spheres[0]); ++i)
+	for (size_t i = 0; i < g_spheres.count; ++i)
 	{
-		struct Sphere* sphere = &g_spheres[i];
-		sphere->glName = i + 1;
-		sphere->colorIdx = i % ( sizeof(g_colors) / sizeof(g_colors[0]) );
-		sphere->zSpeed = RandomInt1to20() / 40.0f;
-		sphere->zSpeedDefault = sphere->zSpeed;
-		sphere->radius = 1.0;
-
-		printf("Set sphere %d to color %s (idx: %d), speed %f, radius %f, offset %f\n",
-				sphere->glName,
-				g_colorNames[sphere->colorIdx], sphere->colorIdx,
-				sphere->zSpeed,
-				sphere->radius,
-				sphere->xOffset);
+		size_t lane = i % lanes;
+		size_t row = i / lanes;
+		g_spheres.xOffset[i] = (lane - (lanes - 1) / 2.0f) * laneWidth;
+		g_spheres.zDistance[i] = SPHERES_Z_WRAP * row / rows;
+		g_spheres.colorIdx[i] = i % ( sizeof(g_colors) / sizeof(g_colors[0]) );
+		g_spheres.zSpeed[i] = RandomInt1to20() / 40.0f;
+		g_spheres.zSpeedDefault[i] = g_spheres.zSpeed[i];
+		g_spheres.radius[i] = 1.0;
+		g_spheres.rotation[i] = (g_spheres.zDistance[i] / g_spheres.radius[i]) *
+				(GLfloat) (180.0 / M_PI);
+
+		if (i < 8)
+			printf("Set sphere %zu to color %s (idx: %d), speed %f, radius %f, offset %f\n",
+					i + 1,
+					g_colorNames[g_spheres.colorIdx[i]], g_spheres.colorIdx[i],
+					g_spheres.zSpeed[i],
+					g_spheres.radius[i],
+					g_spheres.xOffset[i]);
+		else if (i == 8)
+			printf("... and %zu more spheres\n", g_spheres.count - 8);
 	}
+
+	memcpy(g_spheres.zDistancePrev, g_spheres.zDistance,
+			sizeof(GLfloat) * g_spheres.count);
+	SpheresInterpolate(&g_spheres, 0, g_spheres.count, 0.0f, 0.0f);
 }
 
 static void InitData()
@@ -167,28 +347,43 @@ static void InitData()
 	ResetData();
 
 	memset(&g_floor, 0, sizeof(g_floor));
-	g_floor.width = 512;
-	g_floor.height = 1024;
-	int size = sizeof(GLubyte) * 4 * g_floor.width * g_floor.height;
+	if (FLOOR_MODE_TILE == g_options.floorMode)
+	{
+		g_floor.width = FLOOR_TILE;
+		g_floor.height = FLOOR_TILE;
+		g_floor.format = CHECK_IMAGE_L8;
+	}
+	else
+	{
+		g_floor.width = FLOOR_WIDTH;
+		g_floor.height = FLOOR_HEIGHT;
+		g_floor.format = CHECK_IMAGE_RGBA8;
+	}
+	g_floor.repeatS = (GLfloat) FLOOR_WIDTH / g_floor.width;
+	g_floor.repeatT = (GLfloat) FLOOR_HEIGHT / g_floor.height;
+	int size = sizeof(GLubyte) * g_floor.width * g_floor.height *
+			(CHECK_IMAGE_L8 == g_floor.format ? 1 : 4);
 	g_floor.image = malloc(size);
-	memset(g_floor.image, 0, size);
-	makeCheckImage(g_floor.image, g_floor.width, g_floor.height);
+	if (!g_floor.image || makeCheckImageEx(g_floor.image, g_floor.width,
+			g_floor.height, FLOOR_TILE / 2, g_floor.format))
+	{
+		printf("Error: cannot create the floor texture\n");
+		exit(1);
+	}
 }
 
-static void InitGL()
+/*
+ * Returns 0 on success, -1 if passes cannot be composited: the float FBO
+ * backends fell back to glAccum() on a context without an accumulation
+ * buffer.
+ */
+static int InitGL()
 {
-	GLfloat mat_ambient[] = { 1.0, 1.0, 1.0, 1.0 };
-	glMaterialfv(GL_FRONT, GL_AMBIENT, mat_ambient);
-
-	GLfloat mat_specular[] = { 1.0, 1.0, 1.0, 1.0 };
-	glMaterialfv(GL_FRONT, GL_SPECULAR, mat_specular);
-	glMaterialf(GL_FRONT, GL_SHININESS, 50.0);
-
-	GLfloat light_position[] = { 0.0, 20.0, 0.0, 1.0 };
-	glLightfv(GL_LIGHT0, GL_POSITION, light_position);
-
-	GLfloat lm_ambient[] = { 0.2, 0.2, 0.2, 1.0 };
-	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lm_ambient);
+	glMaterialfv(GL_FRONT, GL_AMBIENT, g_lighting.ambient);
+	glMaterialfv(GL_FRONT, GL_SPECULAR, g_lighting.specular);
+	glMaterialf(GL_FRONT, GL_SHININESS, g_lighting.shininess);
+	glLightfv(GL_LIGHT0, GL_POSITION, g_lighting.position);
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, g_lighting.modelAmbient);
 
 	glEnable(GL_LIGHTING);
 	glEnable(GL_LIGHT0);
@@ -197,6 +392,8 @@ static void InitGL()
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glShadeModel (GL_FLAT);
+	/* Sphere meshes are unit spheres scaled to their radius */
+	glEnable(GL_RESCALE_NORMAL);
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glGenTextures(1, &g_floor.texName);
@@ -204,17 +401,114 @@ static void InitGL()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, g_floor.width, g_floor.height,
-			0, GL_RGBA, GL_UNSIGNED_BYTE, g_floor.image);
+	if (FLOOR_MODE_TILE == g_options.floorMode)
+	{
+		/*
+		 * The checks are grey, so one channel is enough. Trilinear filtering
+		 * fades distant checks to grey instead of shimmering, anisotropic
+		 * filtering keeps the floor sharp at grazing angles. Drivers filter
+		 * anisotropically in their own ways, so the software renderer does
+		 * not, and --aniso 1 gives a GL image to compare it with.
+		 */
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+				GL_LINEAR_MIPMAP_LINEAR);
+		if (g_options.anisotropy > 1 &&
+			GLHasExtension("GL_EXT_texture_filter_anisotropic"))
+		{
+			GLfloat maxAniso = 1.0f;
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAniso);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+					fminf(maxAniso, g_options.anisotropy));
+		}
+		gluBuild2DMipmaps(GL_TEXTURE_2D, GL_LUMINANCE8, g_floor.width,
+				g_floor.height, GL_LUMINANCE, GL_UNSIGNED_BYTE, g_floor.image);
+	}
+	else
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, g_floor.width, g_floor.height,
+				0, GL_RGBA, GL_UNSIGNED_BYTE, g_floor.image);
+	}
+	if (g_options.software && SoftRasterInit(&g_lighting, g_floorQuad,
+			g_floor.repeatS, g_floor.repeatT, g_floor.image, g_floor.width,
+			g_floor.height, CHECK_IMAGE_L8 == g_floor.format ? 1 : 4,
+			FLOOR_MODE_TILE == g_options.floorMode))
+	{
+		printf("Error: out of memory for the software renderer\n");
+		g_options.software = 0;
+	}
+	free(g_floor.image);
+	g_floor.image = 0;
 
 	glClearColor(0.0, 0.0, 0.0, 1.0);
 	glClearAccum(0.0, 0.0, 0.0, 0.0);
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	enum AccumBackend backend = AccumInit(g_options.accumBackend,
+			viewport[2], viewport[3]);
+	printf("Accumulation backend: %s\n", AccumBackendName(backend));
+
+	g_state.instancingSupported = (0 == InstancingInit());
+	if (!g_state.instancingSupported)
+		printf("Warning: instanced sphere rendering is not supported\n");
+
+	/* Meshes are cached on first use, build them all before drawing */
+	for (GLint level = 0; level < LOD_LEVELS; ++level)
+	{
+		if (!LodMesh(level))
+		{
+			printf("Error: out of memory for sphere meshes\n");
+			return -1;
+		}
+	}
+
+	GLint accumBits = 0;
+	glGetIntegerv(GL_ACCUM_RED_BITS, &accumBits);
+	if (backend == ACCUM_BACKEND_GL && 0 == accumBits && !g_options.software)
+	{
+		if (g_options.accumBackend != ACCUM_BACKEND_GL)
+		{
+			printf("Error: no float FBO support and no accumulation buffer, "
+					"passes cannot be composited\n");
+			return -1;
+		}
+		printf("Warning: no accumulation buffer, glAccum() passes are not "
+				"composited\n");
+	}
+
+	/*
+	 * Headless frames are exactly timeStep ms apart in simulated time.
+	 * Windowed ones come at the display rate, stamped with the target.
+	 */
+	GLuint headlessStep = g_options.headless ? g_options.timeStep : 0;
+	if (g_options.capturePath && CaptureStart(g_options.capturePath,
+			CaptureFormatFromPath(g_options.capturePath), g_options.width,
+			g_options.height, headlessStep ? 1000 : g_fpsTarget,
+			headlessStep ? headlessStep : 1))
+		g_options.capturePath = 0;
+	return 0;
 }
 
 
 static void Cleanup()
 {
+	CaptureStop();
+	CullListFree(&g_visible);
+	LodCleanup();
+	PickGridFree(&g_pickGrid);
+	SpheresFree(&g_spheres);
+	InstancingCleanup();
+	SphereMeshCleanup();
+	MsaaCleanup();
+	TaaCleanup();
+	DofCleanup();
+	MotionBlurCleanup();
+	SoftRasterCleanup();
+	AccumCleanup();
+	accMatrixCacheFree(&g_jitterMatrices);
+	ThreadPoolCleanup();
+
 	if (g_floor.image)
 	{
 		free(g_floor.image);
@@ -223,17 +517,69 @@ static void Cleanup()
 }
 
 
+static GLuint UseInstancing()
+{
+	return g_userSettings.instancing && g_state.instancingSupported &&
+			!g_options.software;
+}
+
+
+static void SwapBuffers()
+{
+#ifdef HAVE_EGL
+	if (g_options.headless)
+	{
+		HeadlessSwapBuffers();
+		return;
+	}
+#endif
+	glutSwapBuffers();
+}
+
+
 static void PrintData()
 {
 	if (g_userSettings.debug)
 	{
 		printf("\n=====================\n");
-		printf("Time: %d\n", glutGet(GLUT_ELAPSED_TIME));
+		printf("Time: %d\n", ElapsedTime());
 		printf("FPS: %u\n", g_state.fps);
-		printf("AA jitter: %u\n", g_userSettings.enableAA);
-		printf("Depth of field: %u\n", g_userSettings.enableDOF);
+		printf("Spheres: %zu (%s time step, %u threads)\n", g_spheres.count,
+				SpheresTimeStepIsa(), ThreadPoolThreads());
+		printf("Visible spheres: %zu of %zu\n", g_visible.count, g_spheres.count);
+		GLsizei triangles = 0;
+		for (GLint level = 0; level < LOD_LEVELS; ++level)
+			triangles += g_lod.count[level] * LodTriangles(level);
+		printf("Sphere LOD: %.2f px error, %u %u %u %u per level, "
+				"%d triangles per pass\n", g_userSettings.lodError,
+				(GLuint) g_lod.count[0], (GLuint) g_lod.count[1],
+				(GLuint) g_lod.count[2], (GLuint) g_lod.count[3], triangles);
+		printf("Sphere rendering: %s\n", g_options.software ?
+				"software rasterizer" : UseInstancing() ? "instanced" : "per sphere");
+		printf("Accumulation: %s\n", g_options.software ?
+				"software" : AccumBackendName(AccumGetBackend()));
+		if (g_state.msaa)
+			printf("AA mode: %ux MSAA\n", g_state.msaa);
+		else if (g_userSettings.taa)
+			printf("AA mode: TAA, %u jitter samples\n", TAA_SAMPLES);
+		else if (g_userSettings.enableAA)
+			printf("AA mode: %ux jitter\n", g_userSettings.enableAA);
+		else
+			printf("AA mode: disabled\n");
+		if (g_userSettings.governor && g_userSettings.progressive)
+			printf("Governor: off while progressive\n");
+		else if (g_userSettings.governor)
+			printf("Governor: %u passes per frame, %.2f ms per pass\n",
+					g_state.jitterSamples, g_state.passMs);
+		printf("Depth of field: %u (%s)\n", g_userSettings.enableDOF,
+				g_userSettings.dofPost ? "post process" : "eye jitter");
+		if (g_userSettings.progressive)
+			printf("Progressive: %u of %u passes, %u per frame\n",
+					g_progressive.samples, g_progressive.jitterMax,
+					g_userSettings.progressive);
 		printf("FoV angle: %f\n", g_userSettings.fovAngle);
-		printf("Motion blur: %u\n", g_userSettings.enableBlur);
+		printf("Motion blur: %u (%s)\n", g_userSettings.enableBlur,
+				g_userSettings.blurPost ? "post process" : "re-render");
 	}
 	glutTimerFunc(1000, PrintData, 0);
 }
@@ -242,7 +588,7 @@ static void PrintData()
 static void UpdateFps()
 {
 	++g_state.framesRendered;
-	GLuint fpsTimeCurrent = glutGet(GLUT_ELAPSED_TIME);
+	GLuint fpsTimeCurrent = ElapsedTime();
 	if (fpsTimeCurrent - g_state.baseTime > 1000)
 	{
 		g_state.fps = ceil( g_state.framesRendered*1000.0 /
@@ -253,70 +599,191 @@ static void UpdateFps()
 }
 
 
-static void SphereTimeStep(struct Sphere* sphere, GLfloat factor)
+/* Spheres per thread pool chunk, a multiple of 8 keeps SIMD batches aligned */
+#define SIMULATION_GRAIN 2048
+
+/* Most ticks run per frame, time past that is dropped after a long stall */
+#define SIMULATION_MAX_TICKS 8
+
+/* Hit spheres smear over this many ticks of their motion with blur on */
+#define BLUR_TICKS 4.0f
+
+/* Samples per pixel along the velocity of post process blur */
+#define BLUR_POST_SAMPLES 10
+
+/* Accumulation loop passes when DOF or blur needs it without AA jitter */
+#define DEFAULT_PASSES 8
+
+struct SimulationJob
+{
+	GLuint now;
+	GLuint hitDuration;
+	GLfloat alpha;
+	GLfloat hitLag;
+};
+
+static void SimulationChunk(void* ctx, size_t first, size_t last)
+{
+	const struct SimulationJob* job = ctx;
+	SpheresTimeStep(&g_spheres, first, last, 1.0f, job->now,
+			job->hitDuration);
+}
+
+/*
+ * Every sphere steps independently, so splitting the range across threads
+ * gives the same result as one SpheresTimeStep() over all of it.
+ */
+static void SimulationStep(GLuint now)
+{
+	struct SimulationJob job = {
+			.now = now,
+			.hitDuration = g_userSettings.hitDuration
+	};
+	ThreadPoolFor(g_spheres.count, SIMULATION_GRAIN, SimulationChunk, &job);
+}
+
+/*
+ * Runs every whole tick of 1000 / g_fpsTarget ms since the last one, so
+ * motion is the same whatever the frame rate, then records how far the
+ * frame is into the next tick for InterpolateSpheres(). Returns the number
+ * of ticks run.
+ */
+static GLuint AdvanceSimulation()
 {
-	if (sphere->hit &&
-		((glutGet(GLUT_ELAPSED_TIME) - sphere->hit) > g_userSettings.hitDuration))
+	const GLuint tick = 1000 / g_fpsTarget;
+	GLuint now = ElapsedTime();
+
+	/* Keep simTime trailing the clock so unpausing does not jump */
+	if (g_state.paused)
 	{
-		sphere->hit = 0;
-		sphere->zSpeed = sphere->zSpeedDefault;
+		g_state.simTime = now - (GLuint) (g_state.simAlpha * tick);
+		return 0;
 	}
 
-	GLfloat step = sphere->zSpeed * factor;
-	sphere->zDistance -= step;
-	assert(sphere->zDistance <= 0.0);
+	if (now - g_state.simTime > tick * SIMULATION_MAX_TICKS)
+		g_state.simTime = now - tick * SIMULATION_MAX_TICKS;
 
-	sphere->rotation = (sphere->zDistance / sphere->radius) * (180.0 / M_PI);
-	if (sphere->zDistance < -48.0)
+	GLuint ticks = 0;
+	while (now - g_state.simTime >= tick)
 	{
-		sphere->zDistance = 0.0;
-		sphere->rotation = 0.0;
+		g_state.simTime += tick;
+		SimulationStep(g_state.simTime);
+		++ticks;
 	}
+
+	g_state.simAlpha = (GLfloat) (now - g_state.simTime) / tick;
+	return ticks;
 }
 
+static void InterpolateChunk(void* ctx, size_t first, size_t last)
+{
+	const struct SimulationJob* job = ctx;
+	SpheresInterpolate(&g_spheres, first, last, job->alpha, job->hitLag);
+}
 
-void TimerTimeStep(int x)
+/* Places spheres for drawing between the last two ticks, hitLag is in ticks */
+static void InterpolateSpheres(GLfloat hitLag)
 {
-	for (int i = 0; i < sizeof(g_spheres) / sizeof(g_spheres[0]); ++i)
-	{
-		struct Sphere *sphere = &g_spheres[i];
-		if (g_userSettings.enableBlur && sphere->hit)
-			continue;
-		SphereTimeStep(sphere, 1.0f);
-	}
+	struct SimulationJob job = {
+			.alpha = g_state.simAlpha,
+			.hitLag = hitLag
+	};
+	ThreadPoolFor(g_spheres.count, SIMULATION_GRAIN, InterpolateChunk, &job);
+}
 
+
+static void Idle()
+{
 	glutPostRedisplay();
-	glutTimerFunc(1000 / g_fpsTarget, TimerTimeStep, 0);
 }
 
 
-void RenderSphere(struct Sphere* sphere)
+void RenderSphere(size_t i)
 {
 	glPushMatrix();
-	glPushName(sphere->glName); 
 
-	glMaterialfv(GL_FRONT, GL_DIFFUSE, sphere->hit ?
-			g_red : g_colors[sphere->colorIdx]);
+	glMaterialfv(GL_FRONT, GL_DIFFUSE, g_spheres.hit[i] ?
+			g_red : g_colors[g_spheres.colorIdx[i]]);
 
-	glTranslatef (sphere->xOffset, -1.0, sphere->zDistance);
+	glTranslatef (g_spheres.xOffset[i], -1.0, g_spheres.zDrawn[i]);
 
-	glRotatef (sphere->rotation, 1.0, 0.0, 0.0);
+	glRotatef (g_spheres.rotationDrawn[i], 1.0, 0.0, 0.0);
 	glRotatef (90.0, 0.0, 1.0, 0.0);
-	glutSolidSphere (sphere->radius, 24, 24);
+	glScalef (g_spheres.radius[i], g_spheres.radius[i], g_spheres.radius[i]);
+	SphereMeshDraw(LodMesh(g_spheres.lod[i]));
 
-	glPopName();
 	glPopMatrix();
 }
 
 
+/*
+ * Rebuilds the visible list against g_frustum, groups it by level of detail
+ * and refreshes the instance data, needed whenever spheres move.
+ */
+static void UpdateVisible()
+{
+	if (g_userSettings.culling ?
+			CullSpheres(&g_frustum, &g_spheres, &g_visible) :
+			CullNone(&g_spheres, &g_visible))
+	{
+		printf("Error: out of memory for the visible sphere list\n");
+		exit(1);
+	}
+
+	if (LodSelect(&g_spheres, g_visible.index, g_visible.count,
+			g_pixelsPerUnit, g_userSettings.lodError, &g_lod))
+	{
+		printf("Warning: out of memory for sphere LOD, drawing full detail\n");
+		g_userSettings.lodError = 0.0f;
+	}
+
+	/* TAA and post process blur draw motion vectors instanced either way */
+	if ((UseInstancing() || g_userSettings.taa || g_state.blurPost) &&
+		InstancingUpdate(&g_spheres, g_visible.index, g_visible.count,
+				g_colors, g_red))
+	{
+		printf("Error: out of memory for sphere instances, drawing spheres "
+				"one at a time\n");
+		g_state.instancingSupported = 0;
+	}
+}
+
+
 static void RenderObjects()
 {
-	glInitNames();
-	for (int i = 0; i < sizeof(g_spheres) / sizeof(g_spheres[0]); ++i)
+	if (UseInstancing())
 	{
-		struct Sphere *sphere = &g_spheres[i];
-		RenderSphere(sphere);
+		for (GLint level = 0; level < LOD_LEVELS; ++level)
+			InstancingDraw(LodMesh(level), g_lod.first[level], g_lod.count[level]);
+		return;
 	}
+
+	for (size_t n = 0; n < g_visible.count; ++n)
+		RenderSphere(g_visible.index[n]);
+}
+
+
+/* 1 if any sphere is hit, so its motion needs blurring this frame */
+static GLuint AnyHit()
+{
+	for (size_t i = 0; i < g_spheres.count; ++i)
+	{
+		if (g_spheres.hit[i])
+			return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Motion blur for a pass at time, 0 to 1, of the shutter. Hit spheres are
+ * drawn that far back along their path, BLUR_TICKS ticks back at most.
+ * Only what is drawn moves, the simulation is left alone.
+ */
+static void BlurPass(GLfloat time)
+{
+	InterpolateSpheres(BLUR_TICKS * time);
+	UpdateVisible();
 }
 
 
@@ -324,52 +791,167 @@ static void RenderFloor()
 {
 	glPushMatrix();
 	glEnable(GL_TEXTURE_2D);
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+	/* GL_DECAL is undefined for luminance, GL_REPLACE matches it for opaque */
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 	glBindTexture(GL_TEXTURE_2D, g_floor.texName);
+	GLfloat s = g_floor.repeatS;
+	GLfloat t = g_floor.repeatT;
 	glBegin(GL_QUADS);
-	glTexCoord2f(0.0, 0.0); glVertex3f(-5.0, -2.0, -50.0);
-	glTexCoord2f(0.0, 1.0); glVertex3f(-5.0, -2.0, 1.0);
-	glTexCoord2f(1.0, 1.0); glVertex3f(5.0, -2.0, 1.0);
-	glTexCoord2f(1.0, 0.0); glVertex3f(5.0, -2.0, -50.0);
+	for (int i = 0; i < 4; ++i)
+	{
+		glTexCoord2f(g_floorQuad[i][0] * s, g_floorQuad[i][1] * t);
+		glVertex3fv(&g_floorQuad[i][2]);
+	}
 	glEnd();
 	glDisable(GL_TEXTURE_2D);
 	glPopMatrix();
 }
 
 
-static jitter_point* JitterArray(GLint match)
+/*
+ * Computes g_frustum, a frustum holding every pass frustum this frame.
+ * accFrustum() shifts the near plane window by
+ * dx = -(pixdx * width / viewport width + eyedx * near / focus) and moves
+ * the eye by eyedx, so with DOF the passes no longer share an apex; the
+ * unjittered frustum is grown to include the corners of each of them.
+ * samples is 0 when there is no accumulation loop.
+ */
+static void CullFrame(GLint* viewport, GLuint enableAA, GLuint enableDOF,
+		const struct PassSample* samples, GLuint jitterMax)
 {
-	jitter_point* rv = 0;
-	for (int test = match; rv == 0 && test <= 66; ++test)
+	const GLdouble near = 1.0;
+	const GLdouble far = 100.0;
+	GLdouble top = near * tan(g_userSettings.fovAngle * M_PI / 360.0);
+	GLdouble right = top * (GLdouble) viewport[2] / (GLdouble) viewport[3];
+	GLdouble focus = g_userSettings.focus + 1;
+
+	FrustumFromBounds(&g_frustum, -right, right, -top, top, near, far);
+	for (GLuint jitter = 0; samples && jitter < jitterMax; ++jitter)
 	{
-		switch(test)
+		GLdouble dx = 0.0;
+		GLdouble dy = 0.0;
+		GLdouble eyex = 0.0;
+		GLdouble eyey = 0.0;
+		if (enableAA)
 		{
-			case 2:
-				rv = j2;
-				break;
-			case 4:
-				rv = j4;
-				break;
-			case 8:
-				rv = j8;
-				break;
-			case 15:
-				rv = j15;
-				break;
-			case 24:
-				rv = j24;
-				break;
-			case 66:
-				rv = j66;
-				break;
-			default:
-				rv = 0;
-				continue;
-				break;
+			dx -= samples[jitter].pixel[0] * 2.0 * right / viewport[2];
+			dy -= samples[jitter].pixel[1] * 2.0 * top / viewport[3];
+		}
+		if (enableDOF)
+		{
+			eyex = 0.33 * samples[jitter].lens[0];
+			eyey = 0.33 * samples[jitter].lens[1];
+			dx -= eyex * near / focus;
+			dy -= eyey * near / focus;
+		}
+
+		/* Near window corners, then far, with the eye moved by eyex, eyey */
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			GLdouble scale = corner < 4 ? 1.0 : far / near;
+			GLdouble point[3] = {
+				eyex + ((corner & 1) ? right : -right) * scale + dx * scale,
+				eyey + ((corner & 2) ? top : -top) * scale + dy * scale,
+				-near * scale
+			};
+			FrustumInclude(&g_frustum, point);
 		}
 	}
-	assert(rv);
-	return rv;
+
+	g_pixelsPerUnit = viewport[3] * near / (2.0 * top);
+}
+
+
+/*
+ * Starts or resumes the progressive accumulation and returns the number of
+ * jitter passes already in it. It restarts when anything but the jitter
+ * sample would change the image: settings, the viewport, or sphere motion.
+ */
+static GLuint ProgressiveBegin(GLint* viewport, GLuint jitterMax,
+		GLuint moved)
+{
+	if (moved || 0 == g_progressive.samples ||
+		g_progressive.jitterMax != jitterMax ||
+		g_progressive.simAlpha != g_state.simAlpha ||
+		memcmp(&g_progressive.settings, &g_userSettings,
+				sizeof(g_userSettings)) ||
+		memcmp(g_progressive.viewport, viewport,
+				sizeof(g_progressive.viewport)))
+	{
+		g_progressive.samples = 0;
+		g_progressive.jitterMax = jitterMax;
+		g_progressive.settings = g_userSettings;
+		g_progressive.simAlpha = g_state.simAlpha;
+		memcpy(g_progressive.viewport, viewport, sizeof(g_progressive.viewport));
+		if (g_options.software)
+			SoftRasterClear();
+		else
+			AccumClear();
+		return 0;
+	}
+
+	if (!g_options.software)
+		AccumResume();
+	return g_progressive.samples;
+}
+
+
+/* Fewest passes the governor drops to */
+#define GOVERNOR_MIN_SAMPLES 2
+
+/* Fraction of the frame budget more passes must fit in to step up */
+#define GOVERNOR_HEADROOM 0.75f
+
+/*
+ * Folds the wall time per pass of this frame into g_state.passMs. Only the
+ * render work is timed, from the start of GlutDisplay() to just before the
+ * swap, which waits for vsync whatever the load. glFinish() first, so
+ * passes still queued on the GPU are counted.
+ */
+static void GovernorMeasure()
+{
+	GLuint passes = g_state.passes - g_state.framePasses;
+	if (!g_userSettings.governor || 0 == passes)
+		return;
+
+	glFinish();
+	GLfloat sample = (NowMs() - g_state.frameStartMs) / passes;
+	g_state.passMs = g_state.passMs > 0.0f ?
+			0.8f * g_state.passMs + 0.2f * sample : sample;
+}
+
+/*
+ * Passes for the jitter loop. Without the governor this is ceiling, and so
+ * in progressive mode, where g_userSettings.progressive already bounds the
+ * passes per frame and a new count would restart the accumulation. With
+ * the governor, the most passes up to ceiling that fit in 1000 / g_fpsTarget
+ * ms at the measured cost per pass, but at least GOVERNOR_MIN_SAMPLES. It
+ * drops as soon as the current count is over budget, but only grows to what
+ * fits with GOVERNOR_HEADROOM to spare, and at most doubles per frame, since
+ * per frame overhead makes the cost per pass look lower as passes grow.
+ */
+static GLuint JitterSamples(GLuint ceiling)
+{
+	if (!g_userSettings.governor || g_userSettings.progressive ||
+			g_state.passMs <= 0.0f)
+		return ceiling;
+
+	const GLfloat budget = 1000.0f / g_fpsTarget;
+	GLuint current = g_state.jitterSamples ? g_state.jitterSamples : ceiling;
+	GLuint fits = budget / g_state.passMs;
+	GLuint fitsWithHeadroom = budget * GOVERNOR_HEADROOM / g_state.passMs;
+
+	GLuint pick = current;
+	if (current > fits)
+		pick = fits;
+	else if (current < fitsWithHeadroom)
+		pick = fitsWithHeadroom < 2 * current ? fitsWithHeadroom : 2 * current;
+
+	if (pick > ceiling)
+		pick = ceiling;
+	if (pick < GOVERNOR_MIN_SAMPLES)
+		pick = ceiling < GOVERNOR_MIN_SAMPLES ? ceiling : GOVERNOR_MIN_SAMPLES;
+	return pick;
 }
 
 
@@ -381,137 +963,335 @@ static void SimplePerspective(GLint* viewport)
 			(GLdouble) viewport[2] / (GLdouble) viewport[3], 1.0, 100.0);
 }
 
+/* Motion of the visible spheres since zDrawnLast, see InstancingDrawMotion() */
+static void DrawMotion(const GLfloat unjittered[16], GLfloat scale)
+{
+	for (GLint level = 0; level < LOD_LEVELS; ++level)
+		InstancingDrawMotion(LodMesh(level), g_lod.first[level],
+				g_lod.count[level], unjittered, scale);
+}
+
+/*
+ * Blurs the back buffer along the motion of hit spheres over the last
+ * BLUR_TICKS ticks, what the blur loop spreads over its passes. Velocity
+ * is drawn with spheres where they are and again where they were, so the
+ * trail they leave gets it too, not just the spheres themselves. Leaves
+ * zDrawnLast where spheres are, as TAA expects.
+ */
+static void PostMotionBlur(GLint* viewport)
+{
+	const size_t bytes = sizeof(GLfloat) * g_spheres.count;
+	GLfloat unjittered[16];
+	SimplePerspective(viewport);
+	glGetFloatv(GL_PROJECTION_MATRIX, unjittered);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	MotionBlurBeginVelocity();
+	InterpolateSpheres(BLUR_TICKS);
+	memcpy(g_spheres.zDrawnLast, g_spheres.zDrawn, bytes);
+	InterpolateSpheres(0.0f);
+	UpdateVisible();
+	DrawMotion(unjittered, 1.0f);
+
+	memcpy(g_spheres.zDrawnLast, g_spheres.zDrawn, bytes);
+	InterpolateSpheres(BLUR_TICKS);
+	UpdateVisible();
+	DrawMotion(unjittered, -1.0f);
+	MotionBlurEndVelocity();
+
+	InterpolateSpheres(0.0f);
+	MotionBlurApply(BLUR_POST_SAMPLES);
+}
+
+/*
+ * Swaps the finished frame in, after the post process motion blur and
+ * DOF that are on. The DOF depth pass is one more unjittered render of
+ * the scene.
+ */
+static void PresentFrame(GLint* viewport)
+{
+	if (g_state.dofPost)
+	{
+		DofBeginDepth();
+		SimplePerspective(viewport);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		RenderFloor();
+		RenderObjects();
+		++g_state.passes;
+		DofEndDepth();
+	}
+
+	if (g_state.blurPost)
+		PostMotionBlur(viewport);
+
+	if (g_state.dofPost)
+		DofApply(1.0, 100.0, g_userSettings.focus + 1,
+				DOF_APERTURE * g_pixelsPerUnit, DOF_MAX_RADIUS * viewport[3]);
+	GovernorMeasure();
+	CaptureFrame(viewport);
+	SwapBuffers();
+}
+
+/* One software pass of the floor and visible spheres, see SoftRasterPass() */
+static void SoftPass(const GLdouble projection[16], const GLdouble view[16],
+		GLfloat weight, GLuint mix)
+{
+	SoftRasterPass(projection, view, &g_spheres, g_visible.index,
+			g_visible.count, g_colors, g_red, weight, mix);
+	++g_state.passes;
+}
+
 static void SimpleDisplay(GLint *viewport)
 {
+	if (g_options.software)
+	{
+		GLdouble projection[16];
+		GLdouble view[16];
+		accPerspectiveMatrices(g_userSettings.fovAngle,
+				(GLdouble) viewport[2] / (GLdouble) viewport[3], 1.0, 100.0,
+				0.0, 0.0, 0.0, 0.0, 1.0, viewport, projection, view);
+		SoftRasterClear();
+		SoftPass(projection, view, 1.0f, 0);
+		SoftRasterPresent();
+		PresentFrame(viewport);
+		return;
+	}
+
+	MsaaBegin();
+	if (g_state.msaa)
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 	RenderFloor();
 	RenderObjects();
-	glutSwapBuffers();
+	++g_state.passes;
+
+	MsaaResolve();
+	PresentFrame(viewport);
+}
+
+
+/*
+ * One pass jittered by the next of TAA_SAMPLES jitter offsets, its
+ * sphere motion, then the blend with the reprojected history.
+ */
+static void TaaDisplay(GLint* viewport)
+{
+	if (g_state.taaFovAngle != g_userSettings.fovAngle)
+	{
+		g_state.taaFovAngle = g_userSettings.fovAngle;
+		TaaReset();
+	}
+
+	const struct PassSample* samples = SamplerPasses(TAA_SAMPLES);
+	GLuint sample = g_state.taaFrame++ % TAA_SAMPLES;
+	GLdouble aspect = (GLdouble) viewport[2] / (GLdouble) viewport[3];
+
+	GLdouble projection[16];
+	GLdouble view[16];
+	accPerspectiveMatrices(g_userSettings.fovAngle, aspect, 1.0, 100.0,
+			samples[sample].pixel[0], samples[sample].pixel[1], 0.0, 0.0, 1.0,
+			viewport, projection, view);
+
+	GLfloat unjittered[16];
+	GLfloat unjitteredView[16];
+	accPerspectiveMatricesf(g_userSettings.fovAngle, aspect, 1.0, 100.0,
+			0.0, 0.0, 0.0, 0.0, 1.0, viewport, unjittered, unjitteredView);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixd(projection);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixd(view);
+
+	TaaBegin();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	RenderFloor();
+	RenderObjects();
+	++g_state.passes;
+
+	/* The floor and camera never move, only spheres need motion vectors */
+	TaaBeginMotion();
+	DrawMotion(unjittered, 1.0f);
+	TaaEndMotion();
+	memcpy(g_spheres.zDrawnLast, g_spheres.zDrawn,
+			sizeof(GLfloat) * g_spheres.count);
+
+	TaaResolve(TAA_BLEND);
+	PresentFrame(viewport);
 }
 
 
 static void GlutDisplay()
 {
+	/* Start of the render work GovernorMeasure() times */
+	g_state.frameStartMs = NowMs();
+	g_state.framePasses = g_state.passes;
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	GLint viewport[4];
 	glGetIntegerv (GL_VIEWPORT, viewport);
 
-	if (0 == g_userSettings.enableAA &&
-		0 == g_userSettings.enableDOF &&
-		0 == g_userSettings.enableBlur)
+	if (g_options.software && (g_userSettings.msaa || g_userSettings.taa ||
+			g_userSettings.dofPost || g_userSettings.blurPost))
 	{
-		SimplePerspective(viewport);
-		SimpleDisplay(viewport);
-		goto finish;
+		printf("Warning: MSAA, TAA and post processing need the GL renderer\n");
+		g_userSettings.msaa = 0;
+		g_userSettings.taa = 0;
+		g_userSettings.dofPost = 0;
+		g_userSettings.blurPost = 0;
 	}
+	g_options.software = SoftRasterConfigure(g_options.software,
+			viewport[2], viewport[3]);
 
 	/*
-	 * This and the prior case are implemented individually only as a proof-of-
-	 * concept, the SGI accPerspective based code below could handle these
-	 * two cases with little change
+	 * MSAA covers edges in one pass, jitter only for DOF and blur then. The
+	 * requested count stays in g_userSettings so 'm' still cycles to off
+	 * when the driver clamps it.
 	 */
-	if (0 == g_userSettings.enableAA &&
-		0 == g_userSettings.enableDOF &&
-		0 != g_userSettings.enableBlur)
+	g_state.msaa = MsaaConfigure(g_userSettings.msaa, viewport[2], viewport[3]);
+	if (g_userSettings.taa && !(g_state.instancingSupported &&
+			InstancingMotionSupported()))
 	{
-		int hasBlur = 0;
-		for (int i = 0; i < sizeof(g_spheres) / sizeof(g_spheres[0]); ++i)
-		{
-			struct Sphere *sphere = &g_spheres[i];
-			if (sphere->hit)
-				++hasBlur;
-		}
-		if (0 == hasBlur)
-		{
-			SimplePerspective(viewport);
-			SimpleDisplay(viewport);
-			goto finish;
-		}
+		printf("Warning: TAA needs the instanced sphere shaders\n");
+		g_userSettings.taa = 0;
+	}
+	g_userSettings.taa = TaaConfigure(g_userSettings.taa,
+			viewport[2], viewport[3]);
+	if (g_userSettings.blurPost && !(g_state.instancingSupported &&
+			InstancingMotionSupported()))
+	{
+		printf("Warning: post process motion blur needs the instanced sphere "
+				"shaders\n");
+		g_userSettings.blurPost = 0;
+	}
+	g_userSettings.blurPost = MotionBlurConfigure(g_userSettings.blurPost,
+			viewport[2], viewport[3]);
+	GLuint enableAA = g_state.msaa || g_userSettings.taa ?
+			0 : g_userSettings.enableAA;
+
+	/* Post process DOF takes the eye jitter out of the accumulation loop */
+	g_userSettings.dofPost = DofConfigure(g_userSettings.dofPost,
+			viewport[2], viewport[3]);
+	g_state.dofPost = g_userSettings.enableDOF && g_userSettings.dofPost;
+	GLuint enableDOF = g_state.dofPost ? 0 : g_userSettings.enableDOF;
+
+	GLuint moved = AdvanceSimulation();
+	InterpolateSpheres(0.0f);
+	GLuint blurring = g_userSettings.enableBlur && AnyHit();
+	g_state.blurPost = blurring && g_userSettings.blurPost;
+	GLuint blurLoop = blurring && !g_state.blurPost;
 
-		glClear(GL_ACCUM_BUFFER_BIT);
-		SimplePerspective(viewport);
-		glMatrixMode(GL_MODELVIEW);
+	/*
+	 * Only used when AA jitter, DOF or blur runs the accPerspective() loop.
+	 * Each pass takes its pixel, lens and shutter time from one sample, so
+	 * the three effects share the passes rather than multiplying them.
+	 */
+	GLuint jitterMax = JitterSamples(enableAA ? enableAA : DEFAULT_PASSES);
+	const struct PassSample* samples = SamplerPasses(jitterMax);
+	GLuint jitterLoop = enableAA || enableDOF || blurLoop;
+
+	/* TAA needs the accumulation loop for DOF and blur like MSAA does */
+	GLuint taa = g_userSettings.taa && !g_state.msaa &&
+			!enableDOF && !blurLoop;
+	if (taa)
+	{
+		CullFrame(viewport, 1, 0, SamplerPasses(TAA_SAMPLES), TAA_SAMPLES);
+		UpdateVisible();
+		TaaDisplay(viewport);
+		goto finish;
+	}
+	TaaReset();
 
-		for (int j = 0; j < 10; ++j)
-		{
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glLoadIdentity();
-			RenderFloor();
-
-			for (int i = 0; i < sizeof(g_spheres) / sizeof(g_spheres[0]); ++i)
-			{
-				struct Sphere *sphere = &g_spheres[i];
-				if (sphere->hit)
-				{
-					GLfloat factor = (-sphere->zDistance + 1.0) / 48.0;
-					SphereTimeStep(sphere, factor);
-				}
-				RenderSphere(sphere);
-			}
+	g_state.jitterSamples = jitterLoop ? jitterMax : 0;
 
-			glAccum(GL_ACCUM, 1.0 / 10.0f);
-		}
+	/* Culled once per frame, every pass draws the same visible list */
+	CullFrame(viewport, enableAA, enableDOF, jitterLoop ? samples : 0,
+			jitterMax);
+	UpdateVisible();
 
-		glAccum(GL_RETURN, 1.0);
-		glutSwapBuffers();
+	if (!jitterLoop)
+	{
+		SimplePerspective(viewport);
+		SimpleDisplay(viewport);
 		goto finish;
 	}
 
 	/* The rest is taken from redbook exercises */
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glClear(GL_ACCUM_BUFFER_BIT);
 
-	GLuint jitterMax = g_userSettings.enableAA ? g_userSettings.enableAA : 8;
-	for (GLuint jitter = 0; jitter < jitterMax; ++jitter)
+	/* Only rebuilt when the view, focus or jitter settings change */
+	if (accMatrixCacheUpdate(&g_jitterMatrices, g_userSettings.fovAngle,
+			(GLdouble) viewport[2]/(GLdouble) viewport[3],
+			1.0, 100.0,
+			g_userSettings.focus + 1,
+			viewport, samples[0].pixel, samples[0].lens,
+			PASS_SAMPLE_STRIDE, jitterMax,
+			enableAA ? 1.0 : 0.0,
+			enableDOF ? 0.33 : 0.0) < 0)
 	{
-		GLdouble pixdx = 0.0;
-		GLdouble pixdy = 0.0;
-		GLdouble eyex = 0.0;
-		GLdouble eyey = 0.0;
-		jitter_point* jitAry = JitterArray(jitterMax);
+		printf("Error: out of memory for jitter matrices\n");
+		goto finish;
+	}
 
-		if (g_userSettings.enableAA)
-		{
-			pixdx = jitAry[jitter].x;
-			pixdy = jitAry[jitter].y;
-		}
+	/*
+	 * Progressive mode adds at most g_userSettings.progressive passes per
+	 * frame to a running mean and shows it, until all jitterMax are in.
+	 */
+	GLuint first = 0;
+	GLuint passes = jitterMax;
+	if (g_userSettings.progressive)
+	{
+		first = ProgressiveBegin(viewport, jitterMax, moved || blurring);
+		passes = jitterMax - first;
+		if (passes > g_userSettings.progressive)
+			passes = g_userSettings.progressive;
+	}
+	else if (g_options.software)
+		SoftRasterClear();
+	else
+		AccumClear();
 
-		if (g_userSettings.enableDOF)
+	for (GLuint pass = 0; pass < passes; ++pass)
+	{
+		GLuint jitter = first + pass;
+		GLfloat weight = g_userSettings.progressive ?
+				1.0f / (jitter + 1) : 1.0f / jitterMax;
+		if (blurLoop)
+			BlurPass(samples[jitter].time);
+
+		if (g_options.software)
 		{
-			eyex = 0.33 * jitAry[jitter].x;
-			eyey = 0.33 * jitAry[jitter].y;
+			SoftPass(g_jitterMatrices.projection + 16 * jitter,
+					g_jitterMatrices.modelview + 16 * jitter, weight,
+					g_userSettings.progressive);
+			continue;
 		}
 
-		accPerspective (g_userSettings.fovAngle,
-				(GLdouble) viewport[2]/(GLdouble) viewport[3],
-				1.0, 100.0,
-				pixdx, pixdy,
-				eyex, eyey,
-				g_userSettings.focus + 1);
+		/* Projection and eye offset, as accPerspective() would load them */
+		accMatrixCacheLoad(&g_jitterMatrices, jitter);
 
-		glMatrixMode(GL_MODELVIEW);
+		MsaaBegin();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glLoadIdentity();
 		RenderFloor();
-
-		for (int i = 0; i < sizeof(g_spheres) / sizeof(g_spheres[0]); ++i)
-		{
-			struct Sphere *sphere = &g_spheres[i];
-			if (g_userSettings.enableBlur && sphere->hit)
-			{
-				GLfloat factor = (-sphere->zDistance + 1.0) / 4.0;
-				SphereTimeStep(sphere, factor);
-			}
-
-			RenderSphere(sphere);
-		}
-
-		glAccum(GL_ACCUM, 1.0 / jitterMax);
+		RenderObjects();
+
+		++g_state.passes;
+		MsaaResolve();
+		if (g_userSettings.progressive)
+			AccumMix(weight);
+		else
+			AccumAdd(weight);
 	}
-	glAccum (GL_RETURN, 1.0);
-	glutSwapBuffers();
+	g_progressive.samples = first + passes;
+	if (g_options.software)
+		SoftRasterPresent();
+	else
+		AccumReturn();
+	PresentFrame(viewport);
 
 finish:
 	UpdateFps();
@@ -521,6 +1301,7 @@ finish:
 static void Reshape(int w, int h)
 {
 	glViewport(0, 0, (GLsizei) w, (GLsizei) h);
+	AccumResize(w, h);
 }
 
 
@@ -566,6 +1347,7 @@ static void Keyboard(unsigned char key, int x, int y)
 
 		case '0':
 			g_userSettings.enableAA = 0;
+			g_userSettings.taa = 0;
 			printf("%c: Disabled AA\n", key);
 			break;
 
@@ -573,21 +1355,103 @@ static void Keyboard(unsigned char key, int x, int y)
 		case '2':
 		case '3':
 			g_userSettings.enableAA = pow(2, key - '0');
+			g_userSettings.taa = 0;
 			printf("%c: Enabled %dX AA\n", key, g_userSettings.enableAA);
 			break;
 
 		case '4':
 			g_userSettings.enableAA = 15;
+			g_userSettings.taa = 0;
 			printf("%c: Enabled %dX AA\n", key, g_userSettings.enableAA);
 			break;
 		case '5':
 			g_userSettings.enableAA = 24;
+			g_userSettings.taa = 0;
 			printf("%c: Enabled %dX AA\n", key, g_userSettings.enableAA);
 			break;
 		case '6':
 			g_userSettings.enableAA = 66;
+			g_userSettings.taa = 0;
 			printf("%c: Enabled %dX AA\n", key, g_userSettings.enableAA);
 			break;
+		case '7':
+			g_userSettings.enableAA = 0;
+			g_userSettings.taa = 1;
+			printf("%c: Enabled TAA\n", key);
+			break;
+
+		case 'm':
+		case 'M':
+			/* 0, 2, 4, 8, 16, 0... clamped to what the driver supports */
+			if (0 == g_userSettings.msaa)
+				g_userSettings.msaa = 2;
+			else if (g_userSettings.msaa < 16)
+				g_userSettings.msaa *= 2;
+			else
+				g_userSettings.msaa = 0;
+			if (g_userSettings.msaa)
+				printf("%c: Enabled %uX MSAA\n", key, g_userSettings.msaa);
+			else
+				printf("%c: Disabled MSAA\n", key);
+			break;
+
+		case 'i':
+		case 'I':
+			g_userSettings.instancing = g_userSettings.instancing ? 0 : 1;
+			printf("%c: %s instanced sphere rendering\n", key,
+					g_userSettings.instancing ? "Enabled" : "Disabled");
+			break;
+
+		case 'c':
+		case 'C':
+			g_userSettings.culling = g_userSettings.culling ? 0 : 1;
+			printf("%c: %s frustum culling\n", key,
+					g_userSettings.culling ? "Enabled" : "Disabled");
+			break;
+
+		case 'l':
+		case 'L':
+			if (0.0f == g_userSettings.lodError)
+				g_userSettings.lodError = 0.5f;
+			else if (g_userSettings.lodError < 2.0f)
+				g_userSettings.lodError *= 2.0f;
+			else
+				g_userSettings.lodError = 0.0f;
+			if (0.0f == g_userSettings.lodError)
+				printf("%c: Disabled sphere LOD\n", key);
+			else
+				printf("%c: Sphere LOD error is %.2f px\n", key,
+						g_userSettings.lodError);
+			break;
+
+		case 'p':
+		case 'P':
+			/* 0, 1, 2, 4, 8, 0... jitter passes per frame */
+			if (0 == g_userSettings.progressive)
+				g_userSettings.progressive = 1;
+			else if (g_userSettings.progressive < 8)
+				g_userSettings.progressive *= 2;
+			else
+				g_userSettings.progressive = 0;
+			if (g_userSettings.progressive)
+				printf("%c: Progressive AA/DOF, %u passes per frame\n", key,
+						g_userSettings.progressive);
+			else
+				printf("%c: Disabled progressive AA/DOF\n", key);
+			break;
+
+		case 'g':
+		case 'G':
+			g_userSettings.governor = g_userSettings.governor ? 0 : 1;
+			printf("%c: %s sample count governor\n", key,
+					g_userSettings.governor ? "Enabled" : "Disabled");
+			break;
+
+		case ' ':
+			g_state.paused = g_state.paused ? 0 : 1;
+			printf("%c: %s simulation\n", key,
+					g_state.paused ? "Paused" : "Resumed");
+			break;
 
 		case 'r':
 		case 'R':
@@ -613,12 +1477,43 @@ static void Keyboard(unsigned char key, int x, int y)
 			printf("%c: %s depth of field \n", key, g_userSettings.enableDOF ? "Enabled" : "Disabled");
 			break;
 
+		case 'v':
+		case 'V':
+			g_userSettings.blurPost = g_userSettings.blurPost ? 0 : 1;
+			printf("%c: %s motion blur\n", key,
+					g_userSettings.blurPost ? "Post process" : "Re-render");
+			break;
+
+		case 'o':
+		case 'O':
+			g_userSettings.dofPost = g_userSettings.dofPost ? 0 : 1;
+			printf("%c: %s depth of field\n", key,
+					g_userSettings.dofPost ? "Post process" : "Eye jitter");
+			break;
+
 		default:
 			break;
 	}
 }
 
 
+static void HitSphere(size_t i)
+{
+	/*
+	 * Stamped with the tick clock the hit expires against, since the frame
+	 * clock runs up to a tick ahead of it. 0 means not hit.
+	 */
+	g_spheres.hit[i] = g_state.simTime ? g_state.simTime : 1;
+	g_spheres.zSpeed[i] *= 2;
+
+	/*
+	 * The hit color changes the image even while paused. Hits only expire
+	 * in simulation ticks, which restart the accumulation anyway.
+	 */
+	g_progressive.samples = 0;
+}
+
+
 static void Mouse(int button, int state, int x, int y)
 {
 	if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN)
@@ -627,56 +1522,429 @@ static void Mouse(int button, int state, int x, int y)
 	GLint viewport[4];
 	glGetIntegerv(GL_VIEWPORT, viewport);
 
-	GLuint selectBuf[512];
-	glSelectBuffer(512, selectBuf);
+	/* Spheres as last drawn, the modelview is the identity for all of them */
+	GLfloat dir[3];
+	PickRayDirection(x, y, viewport, g_userSettings.fovAngle, dir);
 
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
+	size_t i;
+	if (0 == PickGridBuild(&g_pickGrid, &g_spheres) &&
+		0 == PickNearest(&g_pickGrid, &g_spheres, dir, &i))
+	{
+		if (g_userSettings.debug)
+		  printf("clicked sphere %zu\n", i);
 
-	gluPickMatrix((GLdouble) x, (GLdouble) (viewport[3] - y),
-			10.0, 10.0, viewport);
+		HitSphere(i);
+	}
+}
 
-	gluPerspective(g_userSettings.fovAngle,
-			(GLdouble) viewport[2]/(GLdouble) viewport[3],
-			1.0, 100.0);
 
-	glRenderMode(GL_SELECT);
-	RenderObjects();
-	GLint hits = glRenderMode(GL_RENDER);
-	if (hits > 0)
+static void Usage(const char* name)
+{
+	printf("Usage: %s [options]\n"
+		"  --headless          render offscreen (EGL) and print frame timings\n"
+		"  --size WxH          window or offscreen size (default 1024x1024)\n"
+		"  --frames N          headless: frames to render (default 100)\n"
+		"  --timestep MS       headless: simulated ms per frame (default %d)\n"
+		"  --warmup N          headless: untimed frames to render first\n"
+		"  --hit-interval MS   headless: hit every sphere each MS simulated ms\n"
+		"  --seed N            seed sphere speeds instead of /dev/urandom\n"
+		"  --spheres N         number of spheres (default 2)\n"
+		"  --instancing N      1 to draw spheres instanced (default), 0 not\n"
+		"  --culling N         1 to frustum cull spheres (default), 0 not\n"
+		"  --lod-error PX      sphere LOD silhouette error (default %.1f), 0 off\n"
+		"  --threads N         simulation and software renderer threads, 0 for\n"
+		"                      one per CPU (default), 1 for single threaded\n"
+		"  --floor MODE        tile (16x16 mipmapped, default) or image (512x1024)\n"
+		"  --aniso N           tile floor anisotropic filtering limit (default\n"
+		"                      %u), 1 for none as the soft renderer does\n"
+		"  --accum BACKEND     gl (glAccum), fbo16 or fbo32 (default fbo16)\n"
+		"  --renderer NAME     gl (default) or soft, rasterized on the CPU\n"
+		"  --capture FILE      write every frame to FILE: .y4m, .ppm or raw\n"
+		"                      RGB24 for any other name\n"
+		"  --aa N              AA jitter samples, 0 to %u\n"
+		"  --msaa N            multisample AA instead of jitter AA, 0 to disable\n"
+		"  --taa N             1 for temporal AA instead of jitter AA\n"
+		"  --governor N        1 to drop jitter samples below --aa to hold\n"
+		"                      %d fps\n"
+		"  --dof N             depth of field, 0 to disable\n"
+		"  --dof-post N        1 to blur DOF by depth in one pass instead of\n"
+		"                      jittering the eye\n"
+		"  --blur N            motion blur on hit, 0 to disable\n"
+		"  --blur-post N       1 to blur along screen velocity in one pass\n"
+		"                      instead of re-rendering\n"
+		"  --debug             print debug output\n"
+		"  --fov DEGREES       field of view angle (default %.0f)\n"
+		"  --hit-duration MS   time that hits are reported (default %u)\n"
+		"  --focus N           depth of field focus\n"
+		"  --progressive K     render K jitter passes per frame and refine\n"
+		"                      across frames while nothing moves, 0 for all\n",
+		name, 1000 / g_fpsTarget, g_defaultSettings.lodError,
+		g_options.anisotropy, SAMPLER_MAX_SAMPLES, g_fpsTarget,
+		g_defaultSettings.fovAngle,
+		g_defaultSettings.hitDuration);
+}
+
+
+/* Returns 0 on success, -1 if the program should exit with an error */
+static int ParseArgs(int argc, char** argv)
+{
+	enum {
+		OPT_HEADLESS = 256, OPT_SIZE, OPT_FRAMES, OPT_TIMESTEP, OPT_WARMUP,
+		OPT_HIT_INTERVAL, OPT_SEED, OPT_SPHERES, OPT_INSTANCING,
+		OPT_CULLING, OPT_LOD_ERROR, OPT_THREADS, OPT_FLOOR, OPT_ANISO, OPT_ACCUM,
+		OPT_RENDERER, OPT_CAPTURE,
+		OPT_AA, OPT_MSAA, OPT_TAA, OPT_GOVERNOR, OPT_DOF, OPT_DOF_POST, OPT_BLUR, OPT_BLUR_POST, OPT_DEBUG, OPT_FOV, OPT_HIT_DURATION,
+		OPT_FOCUS, OPT_PROGRESSIVE, OPT_HELP
+	};
+	static const struct option longOptions[] = {
+			{ "headless", no_argument, 0, OPT_HEADLESS },
+			{ "size", required_argument, 0, OPT_SIZE },
+			{ "frames", required_argument, 0, OPT_FRAMES },
+			{ "timestep", required_argument, 0, OPT_TIMESTEP },
+			{ "warmup", required_argument, 0, OPT_WARMUP },
+			{ "hit-interval", required_argument, 0, OPT_HIT_INTERVAL },
+			{ "seed", required_argument, 0, OPT_SEED },
+			{ "spheres", required_argument, 0, OPT_SPHERES },
+			{ "instancing", required_argument, 0, OPT_INSTANCING },
+			{ "culling", required_argument, 0, OPT_CULLING },
+			{ "lod-error", required_argument, 0, OPT_LOD_ERROR },
+			{ "threads", required_argument, 0, OPT_THREADS },
+			{ "floor", required_argument, 0, OPT_FLOOR },
+			{ "aniso", required_argument, 0, OPT_ANISO },
+			{ "accum", required_argument, 0, OPT_ACCUM },
+			{ "renderer", required_argument, 0, OPT_RENDERER },
+			{ "capture", required_argument, 0, OPT_CAPTURE },
+			{ "aa", required_argument, 0, OPT_AA },
+			{ "msaa", required_argument, 0, OPT_MSAA },
+			{ "taa", required_argument, 0, OPT_TAA },
+			{ "governor", required_argument, 0, OPT_GOVERNOR },
+			{ "dof", required_argument, 0, OPT_DOF },
+			{ "dof-post", required_argument, 0, OPT_DOF_POST },
+			{ "blur", required_argument, 0, OPT_BLUR },
+			{ "blur-post", required_argument, 0, OPT_BLUR_POST },
+			{ "debug", no_argument, 0, OPT_DEBUG },
+			{ "fov", required_argument, 0, OPT_FOV },
+			{ "hit-duration", required_argument, 0, OPT_HIT_DURATION },
+			{ "focus", required_argument, 0, OPT_FOCUS },
+			{ "progressive", required_argument, 0, OPT_PROGRESSIVE },
+			{ "help", no_argument, 0, OPT_HELP },
+			{ 0, 0, 0, 0 }
+	};
+
+	/* Unknown options are left for glutInit(), e.g. -display */
+	opterr = 0;
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, "", longOptions, 0)) != -1)
 	{
-		for (int i = 0; i < (sizeof(g_spheres) / sizeof(g_spheres[0])); ++i)
+		switch (opt)
 		{
-			struct Sphere *sphere = &g_spheres[i];
-			if (sphere->glName == selectBuf[3] ||
-				(hits > 1 && sphere->glName == selectBuf[7]))
-			{
-				if (g_userSettings.debug)
-				  printf("clicked sphere %d\n", i);
-
-				sphere->hit = glutGet(GLUT_ELAPSED_TIME);
-				sphere->zSpeed *= 2;
-			}
+			case OPT_HEADLESS:
+				g_options.headless = 1;
+				break;
+			case OPT_SIZE:
+				if (2 != sscanf(optarg, "%ux%u", &g_options.width, &g_options.height) ||
+					0 == g_options.width || 0 == g_options.height)
+				{
+					printf("Error: --size expects WxH, got %s\n", optarg);
+					return -1;
+				}
+				break;
+			case OPT_FRAMES:
+				g_options.frames = strtoul(optarg, 0, 10);
+				break;
+			case OPT_TIMESTEP:
+				g_options.timeStep = strtoul(optarg, 0, 10);
+				break;
+			case OPT_WARMUP:
+				g_options.warmup = strtoul(optarg, 0, 10);
+				break;
+			case OPT_HIT_INTERVAL:
+				g_options.hitInterval = strtoul(optarg, 0, 10);
+				break;
+			case OPT_SEED:
+				g_options.seeded = 1;
+				g_options.seed = strtoul(optarg, 0, 10);
+				break;
+			case OPT_SPHERES:
+				g_options.sphereCount = strtoul(optarg, 0, 10);
+				break;
+			case OPT_INSTANCING:
+				g_defaultSettings.instancing = strtoul(optarg, 0, 10) ? 1 : 0;
+				break;
+			case OPT_CULLING:
+				g_defaultSettings.culling = strtoul(optarg, 0, 10) ? 1 : 0;
+				break;
+			case OPT_LOD_ERROR:
+				g_defaultSettings.lodError = fmaxf(strtof(optarg, 0), 0.0f);
+				break;
+			case OPT_THREADS:
+				g_options.threads = strtoul(optarg, 0, 10);
+				break;
+			case OPT_FLOOR:
+				if (0 == strcmp(optarg, "tile"))
+					g_options.floorMode = FLOOR_MODE_TILE;
+				else if (0 == strcmp(optarg, "image"))
+					g_options.floorMode = FLOOR_MODE_IMAGE;
+				else
+				{
+					printf("Error: unknown floor mode %s\n", optarg);
+					return -1;
+				}
+				break;
+			case OPT_ANISO:
+				g_options.anisotropy = strtoul(optarg, 0, 10);
+				break;
+			case OPT_ACCUM:
+				if (0 == strcmp(optarg, "gl"))
+					g_options.accumBackend = ACCUM_BACKEND_GL;
+				else if (0 == strcmp(optarg, "fbo16") || 0 == strcmp(optarg, "fbo"))
+					g_options.accumBackend = ACCUM_BACKEND_FBO16;
+				else if (0 == strcmp(optarg, "fbo32"))
+					g_options.accumBackend = ACCUM_BACKEND_FBO32;
+				else
+				{
+					printf("Error: unknown accumulation backend %s\n", optarg);
+					return -1;
+				}
+				break;
+			case OPT_RENDERER:
+				if (0 == strcmp(optarg, "gl"))
+					g_options.software = 0;
+				else if (0 == strcmp(optarg, "soft"))
+					g_options.software = 1;
+				else
+				{
+					printf("Error: unknown renderer %s\n", optarg);
+					return -1;
+				}
+				break;
+			case OPT_CAPTURE:
+				g_options.capturePath = optarg;
+				break;
+			case OPT_AA:
+				g_defaultSettings.enableAA = strtoul(optarg, 0, 10);
+				if (g_defaultSettings.enableAA > SAMPLER_MAX_SAMPLES)
+				{
+					printf("Error: --aa supports at most %u samples\n",
+							SAMPLER_MAX_SAMPLES);
+					return -1;
+				}
+				break;
+			case OPT_MSAA:
+				g_defaultSettings.msaa = strtoul(optarg, 0, 10);
+				break;
+			case OPT_TAA:
+				g_defaultSettings.taa = strtoul(optarg, 0, 10) ? 1 : 0;
+				break;
+			case OPT_GOVERNOR:
+				g_defaultSettings.governor = strtoul(optarg, 0, 10) ? 1 : 0;
+				break;
+			case OPT_DOF:
+				g_defaultSettings.enableDOF = strtoul(optarg, 0, 10);
+				break;
+			case OPT_DOF_POST:
+				g_defaultSettings.dofPost = strtoul(optarg, 0, 10) ? 1 : 0;
+				break;
+			case OPT_BLUR:
+				g_defaultSettings.enableBlur = strtoul(optarg, 0, 10);
+				break;
+			case OPT_BLUR_POST:
+				g_defaultSettings.blurPost = strtoul(optarg, 0, 10) ? 1 : 0;
+				break;
+			case OPT_DEBUG:
+				g_defaultSettings.debug = 1;
+				break;
+			case OPT_FOV:
+				g_defaultSettings.fovAngle = strtof(optarg, 0);
+				break;
+			case OPT_HIT_DURATION:
+				g_defaultSettings.hitDuration = strtoul(optarg, 0, 10);
+				break;
+			case OPT_FOCUS:
+				g_defaultSettings.focus = strtoul(optarg, 0, 10);
+				break;
+			case OPT_PROGRESSIVE:
+				g_defaultSettings.progressive = strtoul(optarg, 0, 10);
+				break;
+			case OPT_HELP:
+				Usage(argv[0]);
+				exit(0);
+				break;
+			default:
+				if (g_options.headless)
+				{
+					printf("Error: unknown option %s\n", argv[optind - 1]);
+					return -1;
+				}
+				break;
 		}
 	}
+
+	return 0;
+}
+
+
+#ifdef HAVE_EGL
+static int CompareDouble(const void* a, const void* b)
+{
+	double lhs = *(const double*) a;
+	double rhs = *(const double*) b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+
+/* Nearest-rank percentile of an ascending array */
+static double Percentile(const double* sorted, GLuint count, double pct)
+{
+	GLuint rank = ceil(pct / 100.0 * count);
+	return sorted[rank ? rank - 1 : 0];
+}
+
+
+static void HeadlessFrame()
+{
+	g_state.clock += g_options.timeStep;
+	if (g_options.hitInterval &&
+		0 == g_state.clock % g_options.hitInterval)
+	{
+		for (size_t i = 0; i < g_spheres.count; ++i)
+			HitSphere(i);
+	}
+}
+#endif
+
+
+/*
+ * Renders g_options.frames frames offscreen, advancing the simulated clock
+ * by a fixed step per frame so runs are repeatable, then prints the wall
+ * time of every GlutDisplay() call.
+ */
+static int RunHeadless()
+{
+#ifdef HAVE_EGL
+	if (HeadlessInit(g_options.width, g_options.height))
+		return 1;
+
+	InitData();
+	if (InitGL())
+	{
+		Cleanup();
+		HeadlessCleanup();
+		return 1;
+	}
+	Reshape(g_options.width, g_options.height);
+
+	double* frameMs = malloc(sizeof(double) * (g_options.frames + 1));
+	GLuint* frameClock = malloc(sizeof(GLuint) * (g_options.frames + 1));
+	if (!frameMs || !frameClock)
+	{
+		printf("Error: out of memory for frame timings\n");
+		free(frameClock);
+		free(frameMs);
+		Cleanup();
+		HeadlessCleanup();
+		return 1;
+	}
+
+	for (GLuint frame = 0; frame < g_options.warmup; ++frame)
+	{
+		HeadlessFrame();
+		GlutDisplay();
+	}
+
+	GLuint passesStart = g_state.passes;
+	for (GLuint frame = 0; frame < g_options.frames; ++frame)
+	{
+		HeadlessFrame();
+
+		double start = NowMs();
+		GlutDisplay();
+		frameMs[frame] = NowMs() - start;
+		frameClock[frame] = g_state.clock;
+	}
+	GLuint passes = g_state.passes - passesStart;
+
+	printf("frame,clock_ms,render_ms\n");
+	double totalMs = 0.0;
+	for (GLuint frame = 0; frame < g_options.frames; ++frame)
+	{
+		printf("%u,%u,%.3f\n", frame, frameClock[frame], frameMs[frame]);
+		totalMs += frameMs[frame];
+	}
+
+	if (g_options.frames)
+	{
+		qsort(frameMs, g_options.frames, sizeof(frameMs[0]), CompareDouble);
+		printf("summary: size=%ux%u spheres=%zu threads=%u renderer=%s "
+				"aa=%u msaa=%u taa=%u "
+				"dof=%u dof_post=%u blur=%u blur_post=%u "
+				"focus=%u progressive=%u governor=%u frames=%u "
+				"mean_ms=%.3f p50_ms=%.3f p95_ms=%.3f p99_ms=%.3f "
+				"passes=%u passes_per_s=%.1f\n",
+				g_options.width, g_options.height, g_spheres.count,
+				ThreadPoolThreads(), g_options.software ? "soft" : "gl",
+				g_userSettings.enableAA, g_state.msaa,
+				g_userSettings.taa,
+				g_userSettings.enableDOF, g_userSettings.dofPost,
+				g_userSettings.enableBlur, g_userSettings.blurPost,
+				g_userSettings.focus,
+				g_userSettings.progressive, g_userSettings.governor,
+				g_options.frames, totalMs / g_options.frames,
+				Percentile(frameMs, g_options.frames, 50.0),
+				Percentile(frameMs, g_options.frames, 95.0),
+				Percentile(frameMs, g_options.frames, 99.0),
+				passes, totalMs > 0.0 ? passes * 1000.0 / totalMs : 0.0);
+	}
+
+	free(frameClock);
+	free(frameMs);
+	Cleanup();
+	HeadlessCleanup();
+	return 0;
+#else
+	printf("Error: built without EGL, --headless is unavailable\n");
+	return 1;
+#endif
 }
 
 
 int main(int argc, char** argv)
 {
+	g_options.timeStep = 1000 / g_fpsTarget;
+	if (ParseArgs(argc, argv))
+	{
+		Usage(argv[0]);
+		return 1;
+	}
+
+	ThreadPoolInit(g_options.threads);
+	if (g_options.headless)
+		return RunHeadless();
+
 	glutInit(&argc, argv);
-	glutInitDisplayMode (GLUT_DOUBLE | GLUT_RGB | GLUT_ACCUM | GLUT_DEPTH);
-	glutInitWindowSize (1024, 1024);
+	/*
+	 * Every backend can end up on glAccum(), the FBO ones fall back to it,
+	 * so ask for an accumulation buffer whenever the display has one.
+	 */
+	glutInitDisplayMode (GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_ACCUM);
+	if (!glutGet(GLUT_DISPLAY_MODE_POSSIBLE))
+		glutInitDisplayMode (GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+	glutInitWindowSize (g_options.width, g_options.height);
 	glutInitWindowPosition (100, 100);
 	glutCreateWindow (argv[0]);
 	InitData();
-	InitGL();
+	if (InitGL())
+	{
+		Cleanup();
+		return 1;
+	}
 	glutReshapeFunc(Reshape);
 	glutDisplayFunc(GlutDisplay);
 	glutKeyboardFunc(Keyboard);
 	glutMouseFunc(Mouse);
 	glutTimerFunc(1000, PrintData, 0);
-	glutTimerFunc(1000 / g_fpsTarget, TimerTimeStep, 0);
+	glutIdleFunc(Idle);
 	glutMainLoop();
 	Cleanup();
 	return 0;
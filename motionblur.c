@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Motion blur as a post process, along a per pixel screen velocity.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "glcaps.h"
+#include "globjects.h"
+#include "motionblur.h"
+
+/*
+ * Velocity is drawn into velocityFbo (RGBA16F + its own depth), the
+ * finished frame is copied from the back buffer into sceneFbo, and the
+ * blur reads both and draws straight to the back buffer.
+ */
+struct MotionBlurTargets
+{
+	GLuint enabled;
+	GLuint width;
+	GLuint height;
+	GLuint velocityFbo;
+	GLuint velocity; /* float texture */
+	GLuint depth; /* renderbuffer */
+	GLuint sceneFbo;
+	GLuint scene; /* texture */
+	GLuint program;
+	GLint samples; /* uniform location */
+};
+
+static struct MotionBlurTargets g_blur;
+
+/*
+ * Whatever covers a pixel at a time between then and now is what sits
+ * that fraction of the velocity further along it in the current frame.
+ */
+static const char* g_blurShader =
+	"#version 120\n"
+	"uniform sampler2D scene;\n"
+	"uniform sampler2D velocity;\n"
+	"uniform int samples;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_TexCoord[0].xy;\n"
+	"	vec2 v = texture2D(velocity, uv).xy;\n"
+	"	if (v == vec2(0.0))\n"
+	"	{\n"
+	"		gl_FragColor = texture2D(scene, uv);\n"
+	"		return;\n"
+	"	}\n"
+	"	vec3 sum = vec3(0.0);\n"
+	"	for (int i = 0; i < samples; ++i)\n"
+	"		sum += texture2D(scene,\n"
+	"				uv + v * (float(i) / float(samples - 1))).rgb;\n"
+	"	gl_FragColor = vec4(sum / float(samples), 1.0);\n"
+	"}\n";
+
+static int Supported()
+{
+	if (!GLVersionAtLeast(2, 0))
+		return 0;
+	if (GLVersionAtLeast(3, 0))
+		return 1;
+	return GLHasExtension("GL_ARB_framebuffer_object") &&
+			GLHasExtension("GL_ARB_texture_float");
+}
+
+static void DeleteTargets()
+{
+	if (g_blur.velocityFbo)
+		glDeleteFramebuffers(1, &g_blur.velocityFbo);
+	if (g_blur.sceneFbo)
+		glDeleteFramebuffers(1, &g_blur.sceneFbo);
+	if (g_blur.depth)
+		glDeleteRenderbuffers(1, &g_blur.depth);
+	if (g_blur.velocity)
+		glDeleteTextures(1, &g_blur.velocity);
+	if (g_blur.scene)
+		glDeleteTextures(1, &g_blur.scene);
+	if (g_blur.program)
+		glDeleteProgram(g_blur.program);
+
+	g_blur.velocityFbo = 0;
+	g_blur.sceneFbo = 0;
+	g_blur.depth = 0;
+	g_blur.velocity = 0;
+	g_blur.scene = 0;
+	g_blur.program = 0;
+	g_blur.enabled = 0;
+}
+
+/* Returns 0 on success, -1 if the blur shader does not build */
+static int CreateProgram()
+{
+	GLuint fs = GLCompileShader(GL_FRAGMENT_SHADER, 1, &g_blurShader, "motion blur");
+	g_blur.program = GLLinkProgram(&fs, 1, 0, 0, "motion blur");
+	if (!g_blur.program)
+		return -1;
+
+	glUseProgram(g_blur.program);
+	glUniform1i(glGetUniformLocation(g_blur.program, "scene"), 0);
+	glUniform1i(glGetUniformLocation(g_blur.program, "velocity"), 1);
+	g_blur.samples = glGetUniformLocation(g_blur.program, "samples");
+	glUseProgram(0);
+	return 0;
+}
+
+/* Returns 0 on success, -1 if a framebuffer is incomplete */
+static int CreateTargets()
+{
+	GLint oldTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+	GLint oldFbo = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oldFbo);
+
+	/* Samples along the velocity land between texels */
+	g_blur.scene = GLCreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+			g_blur.width, g_blur.height, GL_LINEAR);
+	g_blur.velocity = GLCreateTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT,
+			g_blur.width, g_blur.height, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, oldTexture);
+
+	glGenRenderbuffers(1, &g_blur.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, g_blur.depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
+			g_blur.width, g_blur.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLenum status[2];
+	g_blur.velocityFbo = GLCreateFbo(g_blur.velocity, g_blur.depth);
+	status[0] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	g_blur.sceneFbo = GLCreateFbo(g_blur.scene, 0);
+	status[1] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, oldFbo);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		if (status[i] != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("Warning: motion blur FBO incomplete (0x%x)\n", status[i]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+GLuint MotionBlurConfigure(GLuint enable, GLuint width, GLuint height)
+{
+	if (!enable)
+	{
+		if (g_blur.enabled)
+			DeleteTargets();
+		return 0;
+	}
+
+	if (g_blur.enabled && width == g_blur.width && height == g_blur.height)
+		return 1;
+
+	DeleteTargets();
+	g_blur.width = width;
+	g_blur.height = height;
+
+	if (!Supported())
+	{
+		printf("Warning: post process motion blur needs float FBOs and GLSL\n");
+		return 0;
+	}
+
+	if (CreateTargets() || CreateProgram())
+	{
+		DeleteTargets();
+		return 0;
+	}
+
+	g_blur.enabled = 1;
+	return 1;
+}
+
+void MotionBlurBeginVelocity()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, g_blur.velocityFbo);
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LEQUAL);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_BLEND);
+}
+
+void MotionBlurEndVelocity()
+{
+	glPopAttrib();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void MotionBlurApply(GLuint samples)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_blur.sceneFbo);
+	glBlitFramebuffer(0, 0, g_blur.width, g_blur.height,
+			0, 0, g_blur.width, g_blur.height,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_TRANSFORM_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, g_blur.velocity);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, g_blur.scene);
+
+	glUseProgram(g_blur.program);
+	glUniform1i(g_blur.samples, samples < 2 ? 2 : samples);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0, 0.0); glVertex2f(-1.0, -1.0);
+	glTexCoord2f(1.0, 0.0); glVertex2f(1.0, -1.0);
+	glTexCoord2f(1.0, 1.0); glVertex2f(1.0, 1.0);
+	glTexCoord2f(0.0, 1.0); glVertex2f(-1.0, 1.0);
+	glEnd();
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+
+	glUseProgram(0);
+	glPopAttrib();
+}
+
+void MotionBlurCleanup()
+{
+	DeleteTargets();
+	g_blur.width = 0;
+	g_blur.height = 0;
+}
@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Motion blur as a post process, along a per pixel screen velocity.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef MOTIONBLUR_H_
+#define MOTIONBLUR_H_
+
+#include <GL/gl.h>
+
+/*
+ * (Re)creates the velocity target if post process motion blur was just
+ * enabled or the size changed. Returns 1 if it is in use, 0 if disabled or
+ * float FBOs and GLSL are not supported.
+ */
+extern GLuint MotionBlurConfigure(GLuint enable, GLuint width, GLuint height);
+
+/*
+ * Redirects rendering to the velocity target, cleared to no motion with
+ * its own depth buffer. Draw moving objects with InstancingDrawMotion(),
+ * then call MotionBlurEndVelocity().
+ */
+extern void MotionBlurBeginVelocity();
+extern void MotionBlurEndVelocity();
+
+/*
+ * Replaces every pixel of the back buffer with the mean of samples taken
+ * from it along the pixel's velocity, from the pixel to velocity away.
+ */
+extern void MotionBlurApply(GLuint samples);
+
+extern void MotionBlurCleanup();
+
+#endif /* MOTIONBLUR_H_ */
@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Hardware multisample antialiasing through a multisampled FBO.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "glcaps.h"
+#include "msaa.h"
+
+struct MsaaTarget
+{
+	GLuint requested; /* samples asked for, more than samples if clamped */
+	GLuint samples;
+	GLuint width;
+	GLuint height;
+	GLuint fbo;
+	GLuint color; /* multisampled renderbuffer */
+	GLuint depth; /* multisampled renderbuffer */
+	GLint resolveFbo; /* framebuffer bound when MsaaBegin() was called */
+};
+
+static struct MsaaTarget g_msaa;
+
+static void DeleteTarget()
+{
+	if (g_msaa.fbo)
+		glDeleteFramebuffers(1, &g_msaa.fbo);
+	if (g_msaa.color)
+		glDeleteRenderbuffers(1, &g_msaa.color);
+	if (g_msaa.depth)
+		glDeleteRenderbuffers(1, &g_msaa.depth);
+
+	g_msaa.fbo = 0;
+	g_msaa.color = 0;
+	g_msaa.depth = 0;
+	g_msaa.samples = 0;
+}
+
+static GLuint CreateRenderbuffer(GLenum internalFormat)
+{
+	GLuint rb = 0;
+	glGenRenderbuffers(1, &rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, g_msaa.samples,
+			internalFormat, g_msaa.width, g_msaa.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	return rb;
+}
+
+GLuint MsaaConfigure(GLuint samples, GLuint width, GLuint height)
+{
+	if (samples == g_msaa.requested && width == g_msaa.width &&
+		height == g_msaa.height)
+		return g_msaa.samples;
+
+	DeleteTarget();
+	g_msaa.requested = samples;
+	g_msaa.width = width;
+	g_msaa.height = height;
+	if (0 == samples)
+		return 0;
+
+	if (!GLVersionAtLeast(3, 0) && !GLHasExtension("GL_ARB_framebuffer_object"))
+	{
+		printf("Warning: multisampled FBOs are not supported\n");
+		return 0;
+	}
+
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	g_msaa.samples = samples > (GLuint) maxSamples ? (GLuint) maxSamples : samples;
+	if (g_msaa.samples < 2)
+	{
+		g_msaa.samples = 0;
+		return 0;
+	}
+
+	g_msaa.color = CreateRenderbuffer(GL_RGBA8);
+	g_msaa.depth = CreateRenderbuffer(GL_DEPTH_COMPONENT24);
+
+	GLint oldFbo = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oldFbo);
+	glGenFramebuffers(1, &g_msaa.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_msaa.fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_RENDERBUFFER, g_msaa.color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+			GL_RENDERBUFFER, g_msaa.depth);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, oldFbo);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("Warning: %ux MSAA FBO incomplete (0x%x)\n", samples, status);
+		DeleteTarget();
+	}
+
+	return g_msaa.samples;
+}
+
+void MsaaBegin()
+{
+	if (0 == g_msaa.samples)
+		return;
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &g_msaa.resolveFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_msaa.fbo);
+}
+
+void MsaaResolve()
+{
+	if (0 == g_msaa.samples)
+		return;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, g_msaa.fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_msaa.resolveFbo);
+	glBlitFramebuffer(0, 0, g_msaa.width, g_msaa.height,
+			0, 0, g_msaa.width, g_msaa.height,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_msaa.resolveFbo);
+}
+
+void MsaaCleanup()
+{
+	DeleteTarget();
+	g_msaa.requested = 0;
+	g_msaa.width = 0;
+	g_msaa.height = 0;
+}
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Hardware multisample antialiasing through a multisampled FBO.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef MSAA_H_
+#define MSAA_H_
+
+#include <GL/gl.h>
+
+/*
+ * (Re)creates the multisampled target if the sample count or size changed.
+ * samples is clamped to GL_MAX_SAMPLES. Returns the sample count in use,
+ * 0 if disabled or multisampled FBOs are not supported.
+ */
+extern GLuint MsaaConfigure(GLuint samples, GLuint width, GLuint height);
+
+/*
+ * Redirects rendering to the multisampled target, the caller clears it. The
+ * framebuffer bound at this point receives the resolved image in
+ * MsaaResolve(). Both are no-ops while MSAA is disabled.
+ */
+extern void MsaaBegin();
+extern void MsaaResolve();
+
+extern void MsaaCleanup();
+
+#endif /* MSAA_H_ */
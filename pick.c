@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Mouse picking by casting a ray through a uniform grid of the spheres.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "pick.h"
+
+/* Keeps the grid small when a few spheres are spread far apart */
+#define PICK_MAX_CELLS_PER_AXIS 1024
+
+void PickRayDirection(GLint x, GLint y, const GLint* viewport,
+		GLdouble fovAngle, GLfloat dir[3])
+{
+	GLdouble top = tan(fovAngle * M_PI / 360.0);
+	GLdouble right = top * (GLdouble) viewport[2] / (GLdouble) viewport[3];
+
+	/* Through the pixel center, on the z = -1 plane */
+	GLdouble ndcX = 2.0 * (x - viewport[0] + 0.5) / viewport[2] - 1.0;
+	GLdouble ndcY = 1.0 - 2.0 * (y - viewport[1] + 0.5) / viewport[3];
+	GLdouble dx = ndcX * right;
+	GLdouble dy = ndcY * top;
+	GLdouble len = sqrt(dx * dx + dy * dy + 1.0);
+
+	dir[0] = dx / len;
+	dir[1] = dy / len;
+	dir[2] = -1.0 / len;
+}
+
+/* Truncation is floor here, anything below the grid is clamped first */
+static GLint CellOf(GLfloat v, GLfloat min, GLfloat cellSize, GLint cells)
+{
+	GLfloat f = (v - min) / cellSize;
+	if (!(f > 0.0f))
+		return 0;
+	GLint c = (GLint) f;
+	return c >= cells ? cells - 1 : c;
+}
+
+/* Cell holding the center of sphere i, centers are never below the minimum */
+static size_t CellIndex(const struct PickGrid* grid,
+		const struct Spheres* spheres, size_t i, GLfloat inv)
+{
+	GLint x = (GLint) ((spheres->xOffset[i] - grid->minX) * inv);
+	GLint z = (GLint) ((spheres->zDrawn[i] - grid->minZ) * inv);
+	x = x < grid->cellsX ? x : grid->cellsX - 1;
+	z = z < grid->cellsZ ? z : grid->cellsZ - 1;
+	return (size_t) z * grid->cellsX + x;
+}
+
+static int Reserve(size_t** array, size_t* capacity, size_t count)
+{
+	if (count <= *capacity)
+		return 0;
+
+	free(*array);
+	*array = malloc(sizeof(size_t) * count);
+	*capacity = *array ? count : 0;
+	return *array ? 0 : -1;
+}
+
+int PickGridBuild(struct PickGrid* grid, const struct Spheres* spheres)
+{
+	GLfloat minX = FLT_MAX, maxX = -FLT_MAX;
+	GLfloat minZ = FLT_MAX, maxZ = -FLT_MAX;
+	GLfloat maxRadius = 0.0f;
+	for (size_t i = 0; i < spheres->count; ++i)
+	{
+		GLfloat x = spheres->xOffset[i];
+		GLfloat z = spheres->zDrawn[i];
+		GLfloat r = spheres->radius[i];
+		minX = x < minX ? x : minX;
+		maxX = x > maxX ? x : maxX;
+		minZ = z < minZ ? z : minZ;
+		maxZ = z > maxZ ? z : maxZ;
+		maxRadius = r > maxRadius ? r : maxRadius;
+	}
+	if (0 == spheres->count)
+		minX = maxX = minZ = maxZ = 0.0f;
+
+	GLfloat extent = fmaxf(maxX - minX, maxZ - minZ);
+	grid->cellSize = fmaxf(2.0f * maxRadius, extent / PICK_MAX_CELLS_PER_AXIS);
+	if (!(grid->cellSize > 0.0f))
+		grid->cellSize = 1.0f;
+	grid->minX = minX;
+	grid->minZ = minZ;
+	grid->cellsX = (GLint) ((maxX - minX) / grid->cellSize) + 1;
+	grid->cellsZ = (GLint) ((maxZ - minZ) / grid->cellSize) + 1;
+
+	size_t cells = (size_t) grid->cellsX * grid->cellsZ;
+	if (Reserve(&grid->cellStart, &grid->cellCapacity, cells + 1) ||
+		Reserve(&grid->items, &grid->itemCapacity, spheres->count))
+		return -1;
+	memset(grid->cellStart, 0, sizeof(size_t) * (cells + 1));
+
+	/* Count into cellStart[cell + 1], then prefix sum into offsets */
+	GLfloat inv = 1.0f / grid->cellSize;
+	for (size_t i = 0; i < spheres->count; ++i)
+		++grid->cellStart[CellIndex(grid, spheres, i, inv) + 1];
+	for (size_t c = 0; c < cells; ++c)
+		grid->cellStart[c + 1] += grid->cellStart[c];
+
+	/* Fill moves each cellStart[c] up to the end of cell c, then shift back */
+	for (size_t i = 0; i < spheres->count; ++i)
+		grid->items[grid->cellStart[CellIndex(grid, spheres, i, inv)]++] = i;
+	memmove(grid->cellStart + 1, grid->cellStart, sizeof(size_t) * cells);
+	grid->cellStart[0] = 0;
+
+	return 0;
+}
+
+/* Distance along the ray to the front of sphere i, or FLT_MAX on a miss */
+static GLfloat RaySphere(const struct Spheres* spheres, size_t i,
+		const GLfloat dir[3])
+{
+	GLfloat cx = spheres->xOffset[i];
+	GLfloat cy = -1.0f;
+	GLfloat cz = spheres->zDrawn[i];
+	GLfloat r = spheres->radius[i];
+
+	GLfloat b = cx * dir[0] + cy * dir[1] + cz * dir[2];
+	GLfloat c = cx * cx + cy * cy + cz * cz - r * r;
+	GLfloat disc = b * b - c;
+	if (disc < 0.0f)
+		return FLT_MAX;
+
+	GLfloat t = b - sqrtf(disc);
+	return t >= 0.0f ? t : FLT_MAX;
+}
+
+/* Ray parameters where it enters and leaves slab [min, max] on one axis */
+static void Slab(GLfloat d, GLfloat min, GLfloat max, GLfloat* t0, GLfloat* t1)
+{
+	if (0.0f == d)
+	{
+		/* The eye is at 0 on every axis */
+		int inside = min <= 0.0f && 0.0f <= max;
+		*t0 = inside ? -FLT_MAX : FLT_MAX;
+		*t1 = inside ? FLT_MAX : -FLT_MAX;
+		return;
+	}
+	GLfloat a = min / d;
+	GLfloat b = max / d;
+	*t0 = fminf(a, b);
+	*t1 = fmaxf(a, b);
+}
+
+int PickNearest(const struct PickGrid* grid,
+		const struct Spheres* spheres, const GLfloat dir[3], size_t* index)
+{
+	if (!grid->cellStart)
+		return -1;
+
+	/* Spheres reach at most one cell past the cells holding their centers */
+	GLfloat minX = grid->minX - grid->cellSize;
+	GLfloat minZ = grid->minZ - grid->cellSize;
+	GLint cellsX = grid->cellsX + 2;
+	GLint cellsZ = grid->cellsZ + 2;
+	GLfloat tx0, tx1, tz0, tz1;
+	Slab(dir[0], minX, minX + cellsX * grid->cellSize, &tx0, &tx1);
+	Slab(dir[2], minZ, minZ + cellsZ * grid->cellSize, &tz0, &tz1);
+	GLfloat tEnter = fmaxf(fmaxf(tx0, tz0), 0.0f);
+	GLfloat tExit = fminf(tx1, tz1);
+	if (tEnter > tExit)
+		return -1;
+
+	/* Amanatides and Woo traversal of the x-z projection of the ray */
+	GLfloat px = dir[0] * tEnter;
+	GLfloat pz = dir[2] * tEnter;
+	GLint cx = CellOf(px, minX, grid->cellSize, cellsX);
+	GLint cz = CellOf(pz, minZ, grid->cellSize, cellsZ);
+	GLint stepX = dir[0] > 0.0f ? 1 : -1;
+	GLint stepZ = dir[2] > 0.0f ? 1 : -1;
+	GLfloat deltaX = 0.0f != dir[0] ? grid->cellSize / fabsf(dir[0]) : FLT_MAX;
+	GLfloat deltaZ = 0.0f != dir[2] ? grid->cellSize / fabsf(dir[2]) : FLT_MAX;
+	GLfloat nextX = 0.0f != dir[0] ? (minX +
+			(cx + (stepX > 0)) * grid->cellSize) / dir[0] : FLT_MAX;
+	GLfloat nextZ = 0.0f != dir[2] ? (minZ +
+			(cz + (stepZ > 0)) * grid->cellSize) / dir[2] : FLT_MAX;
+
+	GLfloat best = FLT_MAX;
+	GLfloat cellEnter = tEnter;
+	while (cellEnter <= best)
+	{
+		/*
+		 * (cx, cz) are expanded grid coordinates, so the 3x3 block around
+		 * the cell is grid cells cx - 2 to cx and cz - 2 to cz
+		 */
+		for (GLint z = cz - 2; z <= cz; ++z)
+		{
+			if (z < 0 || z >= grid->cellsZ)
+				continue;
+			for (GLint x = cx - 2; x <= cx; ++x)
+			{
+				if (x < 0 || x >= grid->cellsX)
+					continue;
+				size_t cell = (size_t) z * grid->cellsX + x;
+				for (size_t n = grid->cellStart[cell];
+						n < grid->cellStart[cell + 1]; ++n)
+				{
+					size_t i = grid->items[n];
+					GLfloat t = RaySphere(spheres, i, dir);
+					if (t < best || (t == best && t < FLT_MAX && i < *index))
+					{
+						best = t;
+						*index = i;
+					}
+				}
+			}
+		}
+
+		if (nextX < nextZ)
+		{
+			cellEnter = nextX;
+			nextX += deltaX;
+			cx += stepX;
+			if (cx < 0 || cx >= cellsX)
+				break;
+		}
+		else
+		{
+			cellEnter = nextZ;
+			nextZ += deltaZ;
+			cz += stepZ;
+			if (cz < 0 || cz >= cellsZ)
+				break;
+		}
+		if (FLT_MAX == cellEnter)
+			break;
+	}
+
+	return FLT_MAX == best ? -1 : 0;
+}
+
+void PickGridFree(struct PickGrid* grid)
+{
+	free(grid->cellStart);
+	free(grid->items);
+	memset(grid, 0, sizeof(*grid));
+}
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Mouse picking by casting a ray through a uniform grid of the spheres.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef PICK_H_
+#define PICK_H_
+
+#include <stddef.h>
+
+#include <GL/gl.h>
+
+#include "spheres.h"
+
+/*
+ * Sphere centers all sit at y = -1, so the grid covers x and z only and
+ * every cell is a column. Each sphere is listed once, in the cell holding
+ * its center. Cells are at least a diameter wide, so a sphere only reaches
+ * into the 3x3 block of cells around that one.
+ */
+struct PickGrid
+{
+  GLfloat minX;
+  GLfloat minZ;
+  GLfloat cellSize; /* at least the largest sphere diameter */
+  GLint cellsX;
+  GLint cellsZ;
+  size_t *cellStart; /* cellsX * cellsZ + 1 offsets into items */
+  size_t *items; /* sphere indices, grouped by cell */
+  size_t cellCapacity;
+  size_t itemCapacity;
+};
+
+/*
+ * Eye space direction, normalized, of the ray from the eye through window
+ * pixel (x, y), y counted from the top as GLUT does. Matches the unjittered
+ * gluPerspective(fovAngle, aspect, ...) projection of the viewport.
+ */
+extern void PickRayDirection(GLint x, GLint y, const GLint* viewport,
+		GLdouble fovAngle, GLfloat dir[3]);
+
+/*
+ * Bins the spheres at their drawn positions, (xOffset, -1, zDrawn) in eye
+ * space, with a counting sort. Returns 0 on success, -1 if out of memory.
+ */
+extern int PickGridBuild(struct PickGrid* grid, const struct Spheres* spheres);
+
+/*
+ * Walks the cells along the ray from the eye in direction dir and tests
+ * the spheres listed in the 3x3 block around each. Stops at the first cell
+ * that starts past the nearest hit so far. Returns 0 and sets index to the nearest sphere hit,
+ * -1 if the ray misses them all.
+ */
+extern int PickNearest(const struct PickGrid* grid,
+		const struct Spheres* spheres, const GLfloat dir[3], size_t* index);
+
+extern void PickGridFree(struct PickGrid* grid);
+
+#endif /* PICK_H_ */
@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Checks PickNearest() against a brute force search over every sphere.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+
+#include "pick.h"
+#include "spheres.h"
+
+/* Random rays per sphere count, through pixels and in any direction */
+#define PICK_TEST_RAYS 2000
+
+static double NowMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static GLfloat Uniform(GLfloat min, GLfloat max)
+{
+	return min + (max - min) * (GLfloat) rand() / (GLfloat) RAND_MAX;
+}
+
+/* Same ray test as pick.c, FLT_MAX on a miss */
+static GLfloat RaySphere(const struct Spheres* spheres, size_t i,
+		const GLfloat dir[3])
+{
+	GLfloat cx = spheres->xOffset[i];
+	GLfloat cy = -1.0f;
+	GLfloat cz = spheres->zDrawn[i];
+	GLfloat r = spheres->radius[i];
+
+	GLfloat b = cx * dir[0] + cy * dir[1] + cz * dir[2];
+	GLfloat c = cx * cx + cy * cy + cz * cz - r * r;
+	GLfloat disc = b * b - c;
+	if (disc < 0.0f)
+		return FLT_MAX;
+
+	GLfloat t = b - sqrtf(disc);
+	return t >= 0.0f ? t : FLT_MAX;
+}
+
+/* Nearest sphere hit, lowest index on a tie, -1 on a miss */
+static int BruteNearest(const struct Spheres* spheres, const GLfloat dir[3],
+		size_t* index)
+{
+	GLfloat best = FLT_MAX;
+	for (size_t i = 0; i < spheres->count; ++i)
+	{
+		GLfloat t = RaySphere(spheres, i, dir);
+		if (t < best)
+		{
+			best = t;
+			*index = i;
+		}
+	}
+	return FLT_MAX == best ? -1 : 0;
+}
+
+/*
+ * Spheres laid out like the demo's lanes plus random scatter, so rays see
+ * both crowded cells and empty ones. Some sit around the eye.
+ */
+static void Scatter(struct Spheres* spheres)
+{
+	for (size_t i = 0; i < spheres->count; ++i)
+	{
+		spheres->radius[i] = Uniform(0.2f, 1.5f);
+		spheres->xOffset[i] = rand() % 2 ?
+				(GLfloat) (rand() % 4) * 2.0f - 3.0f : Uniform(-30.0f, 30.0f);
+		spheres->zDrawn[i] = Uniform(SPHERES_Z_WRAP, 2.0f);
+	}
+}
+
+static void RandomRay(GLfloat dir[3])
+{
+	/* Mostly through window pixels, some along the grid axes */
+	switch (rand() % 4)
+	{
+		case 0:
+		{
+			GLfloat len;
+			do
+			{
+				dir[0] = Uniform(-1.0f, 1.0f);
+				dir[1] = Uniform(-1.0f, 1.0f);
+				dir[2] = Uniform(-1.0f, 1.0f);
+				len = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+			} while (len < 0.1f || len > 1.0f);
+			for (int k = 0; k < 3; ++k)
+				dir[k] /= len;
+			if (0 == rand() % 8)
+				dir[rand() % 2 ? 0 : 2] = 0.0f;
+			break;
+		}
+		default:
+		{
+			const GLint viewport[4] = { 0, 0, 64 + rand() % 1024,
+					64 + rand() % 1024 };
+			PickRayDirection(rand() % viewport[2], rand() % viewport[3],
+					viewport, Uniform(20.0f, 90.0f), dir);
+			break;
+		}
+	}
+}
+
+int main()
+{
+	static const size_t counts[] = { 1, 2, 50, 1000, 100000 };
+	int failed = 0;
+
+	srand(1);
+	printf("spheres,rays,hits,build_ms,grid_ms,brute_ms\n");
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		struct Spheres spheres = { 0 };
+		struct PickGrid grid = { 0 };
+		if (SpheresAlloc(&spheres, counts[c]))
+		{
+			printf("Error: cannot allocate %zu spheres\n", counts[c]);
+			return 1;
+		}
+		Scatter(&spheres);
+
+		double start = NowMs();
+		if (PickGridBuild(&grid, &spheres))
+		{
+			printf("Error: cannot build the grid for %zu spheres\n", counts[c]);
+			return 1;
+		}
+		double buildMs = NowMs() - start;
+
+		GLuint hits = 0;
+		double gridMs = 0.0;
+		double bruteMs = 0.0;
+		for (GLuint ray = 0; ray < PICK_TEST_RAYS; ++ray)
+		{
+			GLfloat dir[3];
+			RandomRay(dir);
+
+			size_t expect = 0;
+			size_t index = 0;
+			start = NowMs();
+			int found = PickNearest(&grid, &spheres, dir, &index);
+			gridMs += NowMs() - start;
+			start = NowMs();
+			int expectFound = BruteNearest(&spheres, dir, &expect);
+			bruteMs += NowMs() - start;
+
+			hits += 0 == expectFound;
+			if (found != expectFound || (0 == found && index != expect))
+			{
+				printf("Error: %zu spheres, ray (%f, %f, %f) picked %d/%zu, "
+						"expected %d/%zu\n", counts[c], dir[0], dir[1], dir[2],
+						found, index, expectFound, expect);
+				failed = 1;
+			}
+		}
+
+		printf("%zu,%u,%u,%.3f,%.3f,%.3f\n", counts[c], PICK_TEST_RAYS, hits,
+				buildMs, gridMs, bruteMs);
+		PickGridFree(&grid);
+		SpheresFree(&spheres);
+	}
+	return failed;
+}
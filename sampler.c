@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Low discrepancy pass samples for any pass count.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <math.h>
+
+#include "sampler.h"
+
+/* Set n starts at n * (n - 1) / 2, so all of them fit in one array */
+#define SET_OFFSET(n) ((n) * ((n) - 1) / 2)
+
+static struct PassSample g_sets[SET_OFFSET(SAMPLER_MAX_SAMPLES + 1)];
+static GLboolean g_built[SAMPLER_MAX_SAMPLES + 1];
+
+/* index written in base, mirrored about the radix point */
+static GLdouble RadicalInverse(GLuint index, GLuint base)
+{
+	const GLdouble inverse = 1.0 / base;
+	GLdouble digit = inverse;
+	GLdouble result = 0.0;
+	for (; index; index /= base, digit *= inverse)
+		result += (index % base) * digit;
+	return result;
+}
+
+static GLuint Gcd(GLuint a, GLuint b)
+{
+	while (b)
+	{
+		GLuint t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/*
+ * Shirley and Chiu's concentric map of the unit square onto a disk of
+ * radius 0.5, which keeps evenly spread points evenly spread.
+ */
+static void SquareToDisk(GLdouble u, GLdouble v, GLdouble disk[2])
+{
+	GLdouble a = 2.0 * u - 1.0;
+	GLdouble b = 2.0 * v - 1.0;
+	GLdouble r = 0.0;
+	GLdouble phi = 0.0;
+	if (fabs(a) > fabs(b))
+	{
+		r = a;
+		phi = M_PI / 4.0 * b / a;
+	}
+	else if (b != 0.0)
+	{
+		r = b;
+		phi = M_PI / 2.0 - M_PI / 4.0 * a / b;
+	}
+	disk[0] = 0.5 * r * cos(phi);
+	disk[1] = 0.5 * r * sin(phi);
+}
+
+const struct PassSample* SamplerPasses(GLuint count)
+{
+	if (0 == count || count > SAMPLER_MAX_SAMPLES)
+		return 0;
+
+	struct PassSample* set = &g_sets[SET_OFFSET(count)];
+	if (g_built[count])
+		return set;
+
+	/*
+	 * Pass i takes lens point i * stride mod count. A stride near
+	 * count / golden ratio and coprime to it visits every point once and
+	 * spreads consecutive passes across the lens.
+	 */
+	GLuint stride = (GLuint)(count * 0.618034 + 0.5);
+	while (stride > 1 && Gcd(stride, count) != 1)
+		--stride;
+	if (0 == stride)
+		stride = 1;
+
+	GLdouble mean[5] = { 0.0 };
+	for (GLuint i = 0; i < count; ++i)
+	{
+		/* Halton index 0 is the corner of every dimension, start at 1 */
+		GLdouble lens[2];
+		GLuint j = (i * stride) % count;
+		SquareToDisk((j + 0.5) / count, RadicalInverse(j, 2), lens);
+
+		set[i].pixel[0] = RadicalInverse(i + 1, 2);
+		set[i].pixel[1] = RadicalInverse(i + 1, 3);
+		set[i].lens[0] = lens[0];
+		set[i].lens[1] = lens[1];
+		set[i].time = RadicalInverse(i + 1, 5);
+
+		mean[0] += set[i].pixel[0];
+		mean[1] += set[i].pixel[1];
+		mean[2] += lens[0];
+		mean[3] += lens[1];
+		mean[4] += set[i].time;
+	}
+
+	for (GLuint i = 0; i < count; ++i)
+	{
+		set[i].pixel[0] -= mean[0] / count;
+		set[i].pixel[1] -= mean[1] / count;
+		set[i].lens[0] -= mean[2] / count;
+		set[i].lens[1] -= mean[3] / count;
+
+		/* A rotation rather than a shift keeps time within the shutter */
+		GLdouble time = set[i].time + 0.5 - mean[4] / count;
+		set[i].time = time - floor(time);
+	}
+	g_built[count] = GL_TRUE;
+	return set;
+}
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Low discrepancy pass samples for any pass count.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <GL/gl.h>
+
+/* Largest set SamplerPasses() returns */
+#define SAMPLER_MAX_SAMPLES 256
+
+/* Where one pass of the accumulation loop samples pixel, lens and shutter */
+struct PassSample
+{
+	GLfloat pixel[2]; /* jitter, within about half a pixel of the center */
+	GLfloat lens[2]; /* eye offset, on a disk of radius 0.5 */
+	GLfloat time; /* fraction of the shutter interval, 0 to 1 */
+};
+
+/* GLfloats from one sample to the next, e.g. for accMatrixCacheUpdate() */
+#define PASS_SAMPLE_STRIDE (sizeof(struct PassSample) / sizeof(GLfloat))
+
+/*
+ * Returns count samples. Pixel is Halton bases 2 and 3 and time is Halton
+ * base 5, so every prefix of a set covers them evenly. Lens is a count
+ * point Hammersley set mapped to a disk and visited in a shuffled order,
+ * so the lens is stratified over the whole set and not correlated with
+ * the pixel or time. Pixel and lens offsets are shifted so their mean is
+ * 0, time is rotated so its mean is 0.5. The set is built on first use
+ * and the pointer stays valid and unchanged for the life of the program.
+ * Returns 0 if count is 0 or above SAMPLER_MAX_SAMPLES.
+ */
+extern const struct PassSample* SamplerPasses(GLuint count);
+
+#endif /* SAMPLER_H_ */
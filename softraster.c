@@ -0,0 +1,1070 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Software renderer for the scene, screen tiles rasterized by the thread pool.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#if defined(__SSE2__)
+#define SOFTRASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "softraster.h"
+#include "lod.h"
+#include "spheremesh.h"
+#include "threadpool.h"
+
+/* Pixels on a side of a screen tile, a multiple of 4 for the pixel groups */
+#define TILE_SIZE 64
+
+/*
+ * Window coordinates are snapped to 1/256 pixel. Edge functions are then
+ * evaluated from the same snapped endpoints in the same order by both
+ * triangles sharing an edge, so every pixel center goes to exactly one.
+ */
+#define SUBPIXEL 256.0f
+
+/* Objects per thread pool chunk in triangle setup */
+#define SETUP_GRAIN 4
+
+/* Mipmap levels kept, enough for a 32768 texel texture */
+#define MAX_LEVELS 16
+
+struct Mesh
+{
+	GLint vertexCount;
+	GLsizei triangles;
+	GLfloat* vertices; /* unit sphere, positions double as normals */
+	GLushort* indices;
+};
+
+struct TextureLevel
+{
+	GLuint width;
+	GLuint height;
+	GLfloat* texels; /* RGB */
+};
+
+/* A triangle ready to rasterize, counterclockwise in window coordinates */
+struct Triangle
+{
+	GLfloat x[3];
+	GLfloat y[3];
+	GLfloat z[3]; /* window depth, 0 to 1 */
+	GLfloat color[3]; /* flat color, unless textured */
+	GLint bounds[4]; /* pixels [bounds[0], bounds[2]) x [bounds[1], bounds[3]) */
+	GLint floor; /* index into g_floorCoords, -1 if flat shaded */
+};
+
+/* Perspective correct texture coordinates of a floor triangle */
+struct FloorCoords
+{
+	GLfloat q[3]; /* 1 / w */
+	GLfloat s[3]; /* s / w */
+	GLfloat t[3]; /* t / w */
+};
+
+/* The floor or one sphere, its triangles are a run of g_triangles */
+struct Object
+{
+	size_t first;
+	size_t count;
+	size_t capacity; /* most triangles it can emit, after clipping */
+	GLint tiles[4]; /* tiles its triangles touch, like Triangle.bounds */
+};
+
+/* A clip space vertex and what is interpolated along clipped edges */
+struct ClipVertex
+{
+	GLfloat clip[4];
+	GLfloat s;
+	GLfloat t;
+};
+
+/* Everything SoftRasterPass() hands its thread pool loops */
+struct Pass
+{
+	GLfloat projection[16];
+	GLfloat view[16];
+	GLfloat near; /* eye space distance of the near plane */
+	const struct Spheres* spheres;
+	const size_t* index; /* object n > 0 is sphere index[n - 1] */
+	const GLfloat (*colors)[4];
+	const GLfloat* hitColor;
+	GLfloat weight;
+	GLuint mix;
+	GLuint replace; /* first pass since SoftRasterClear() */
+};
+
+static struct SoftLighting g_lighting;
+static GLfloat g_floorQuad[4][5];
+static struct TextureLevel g_levels[MAX_LEVELS];
+static GLuint g_levelCount; /* 1 unless mipmapped */
+static struct Mesh g_meshes[LOD_LEVELS];
+static GLint g_maxVertices; /* of any level, sizes setup scratch */
+static struct ClipVertex* g_setupScratch; /* g_maxVertices per thread */
+static GLfloat (*g_setupLit)[3];
+
+static GLuint g_width;
+static GLuint g_height;
+static GLuint g_stride; /* width rounded up to whole pixel groups */
+static GLuint g_tilesX;
+static GLuint g_tilesY;
+static GLfloat* g_depth;
+static GLfloat* g_color[3]; /* this pass, one plane per channel */
+static GLfloat* g_accum[3];
+static GLubyte* g_pixels; /* RGBA, what SoftRasterPresent() draws */
+static GLuint g_accumEmpty;
+
+static struct Object* g_objects;
+static size_t g_objectCapacity;
+static struct Triangle* g_triangles;
+static size_t g_triangleCapacity;
+static struct FloorCoords g_floorCoords[4]; /* two quad halves, each split */
+static size_t* g_binStart; /* bin of tile n is g_bins[g_binStart[n]...] */
+static GLuint* g_bins; /* object indices, in drawing order within a bin */
+static size_t g_binCapacity;
+
+/* Box filters level into the next smaller one, as gluBuild2DMipmaps() does */
+static int Downsample(const struct TextureLevel* level,
+		struct TextureLevel* next)
+{
+	next->width = level->width > 1 ? level->width / 2 : 1;
+	next->height = level->height > 1 ? level->height / 2 : 1;
+	next->texels = malloc(sizeof(GLfloat) * 3 * next->width * next->height);
+	if (!next->texels)
+		return -1;
+
+	for (GLuint y = 0; y < next->height; ++y)
+	{
+		GLuint y0 = 2 * y < level->height ? 2 * y : level->height - 1;
+		GLuint y1 = y0 + 1 < level->height ? y0 + 1 : y0;
+		for (GLuint x = 0; x < next->width; ++x)
+		{
+			GLuint x0 = 2 * x < level->width ? 2 * x : level->width - 1;
+			GLuint x1 = x0 + 1 < level->width ? x0 + 1 : x0;
+			const GLfloat* a = level->texels + 3 * (y0 * level->width + x0);
+			const GLfloat* b = level->texels + 3 * (y0 * level->width + x1);
+			const GLfloat* c = level->texels + 3 * (y1 * level->width + x0);
+			const GLfloat* d = level->texels + 3 * (y1 * level->width + x1);
+			GLfloat* out = next->texels + 3 * (y * next->width + x);
+			for (int i = 0; i < 3; ++i)
+				out[i] = 0.25f * (a[i] + b[i] + c[i] + d[i]);
+		}
+	}
+	return 0;
+}
+
+int SoftRasterInit(const struct SoftLighting* lighting,
+		const GLfloat floorQuad[4][5], GLfloat repeatS, GLfloat repeatT,
+		const GLubyte* texture, GLuint width, GLuint height, GLuint channels,
+		GLuint mipmap)
+{
+	SoftRasterCleanup();
+	g_lighting = *lighting;
+	for (int i = 0; i < 4; ++i)
+	{
+		memcpy(g_floorQuad[i], floorQuad[i], sizeof(g_floorQuad[i]));
+		g_floorQuad[i][0] *= repeatS;
+		g_floorQuad[i][1] *= repeatT;
+	}
+
+	struct TextureLevel* base = &g_levels[0];
+	base->width = width;
+	base->height = height;
+	base->texels = malloc(sizeof(GLfloat) * 3 * width * height);
+	if (!base->texels)
+		goto fail;
+	g_levelCount = 1;
+	for (GLuint i = 0; i < width * height; ++i)
+	{
+		for (GLuint c = 0; c < 3; ++c)
+			base->texels[3 * i + c] =
+					texture[channels * i + (channels > c ? c : 0)] / 255.0f;
+	}
+
+	while (mipmap && g_levelCount < MAX_LEVELS &&
+			(g_levels[g_levelCount - 1].width > 1 ||
+			 g_levels[g_levelCount - 1].height > 1))
+	{
+		if (Downsample(&g_levels[g_levelCount - 1], &g_levels[g_levelCount]))
+			goto fail;
+		++g_levelCount;
+	}
+
+	for (GLint level = 0; level < LOD_LEVELS; ++level)
+	{
+		GLint slices;
+		GLint stacks;
+		struct Mesh* mesh = &g_meshes[level];
+		LodTessellation(level, &slices, &stacks);
+		mesh->triangles = SphereMeshTessellate(slices, stacks, &mesh->vertices,
+				&mesh->vertexCount, &mesh->indices) / 3;
+		if (!mesh->vertices || !mesh->indices)
+			goto fail;
+		if (mesh->vertexCount > g_maxVertices)
+			g_maxVertices = mesh->vertexCount;
+	}
+
+	/* Sphere setup runs on every thread of the pool, see SetupChunk() */
+	size_t scratch = (size_t) g_maxVertices * ThreadPoolThreads();
+	g_setupScratch = malloc(sizeof(*g_setupScratch) * scratch);
+	g_setupLit = malloc(sizeof(*g_setupLit) * scratch);
+	if (!g_setupScratch || !g_setupLit)
+		goto fail;
+	return 0;
+
+fail:
+	SoftRasterCleanup();
+	return -1;
+}
+
+static void FreeTargets()
+{
+	free(g_depth);
+	g_depth = 0;
+	for (int c = 0; c < 3; ++c)
+	{
+		free(g_color[c]);
+		free(g_accum[c]);
+		g_color[c] = 0;
+		g_accum[c] = 0;
+	}
+	free(g_pixels);
+	g_pixels = 0;
+	free(g_binStart);
+	g_binStart = 0;
+	g_width = 0;
+	g_height = 0;
+}
+
+static GLfloat* AllocPlane()
+{
+	size_t bytes = sizeof(GLfloat) * g_stride * g_height;
+	return aligned_alloc(16, (bytes + 15) & ~(size_t) 15);
+}
+
+GLuint SoftRasterConfigure(GLuint enable, GLuint width, GLuint height)
+{
+	if (!enable || !g_levelCount)
+	{
+		FreeTargets();
+		return 0;
+	}
+	if (width == g_width && height == g_height)
+		return 1;
+
+	FreeTargets();
+	g_width = width;
+	g_height = height;
+	g_stride = (width + 3) & ~3u;
+	g_tilesX = (g_stride + TILE_SIZE - 1) / TILE_SIZE;
+	g_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	g_depth = AllocPlane();
+	GLuint ok = g_depth != 0;
+	for (int c = 0; c < 3; ++c)
+	{
+		g_color[c] = AllocPlane();
+		g_accum[c] = AllocPlane();
+		ok = ok && g_color[c] && g_accum[c];
+	}
+	g_pixels = malloc(4 * (size_t) width * height);
+	g_binStart = malloc(sizeof(size_t) * (g_tilesX * g_tilesY + 1));
+	if (!ok || !g_pixels || !g_binStart)
+	{
+		printf("Error: out of memory for the software renderer\n");
+		FreeTargets();
+		return 0;
+	}
+	g_accumEmpty = 1;
+	return 1;
+}
+
+void SoftRasterClear()
+{
+	g_accumEmpty = 1;
+}
+
+/* out = m * v for a column major 4x4 matrix */
+static void Transform(const GLfloat m[16], const GLfloat v[4], GLfloat out[4])
+{
+	for (int r = 0; r < 4; ++r)
+		out[r] = m[r] * v[0] + m[4 + r] * v[1] + m[8 + r] * v[2] +
+				m[12 + r] * v[3];
+}
+
+static void Normalize(GLfloat v[3])
+{
+	GLfloat length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if (length > 0.0f)
+	{
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+}
+
+/* Fixed function lighting of one vertex, see struct SoftLighting */
+static void Light(const GLfloat eye[3], const GLfloat normal[3],
+		const GLfloat diffuse[4], GLfloat out[3])
+{
+	const struct SoftLighting* l = &g_lighting;
+	GLfloat toLight[3];
+	for (int i = 0; i < 3; ++i)
+		toLight[i] = l->position[3] != 0.0f ?
+				l->position[i] / l->position[3] - eye[i] : l->position[i];
+	Normalize(toLight);
+
+	GLfloat nDotL = normal[0] * toLight[0] + normal[1] * toLight[1] +
+			normal[2] * toLight[2];
+	nDotL = nDotL > 0.0f ? nDotL : 0.0f;
+
+	GLfloat specular = 0.0f;
+	if (nDotL > 0.0f)
+	{
+		/* Infinite viewer, GL_LIGHT_MODEL_LOCAL_VIEWER is off */
+		GLfloat half[3] = { toLight[0], toLight[1], toLight[2] + 1.0f };
+		Normalize(half);
+		GLfloat nDotH = normal[0] * half[0] + normal[1] * half[1] +
+				normal[2] * half[2];
+		specular = powf(nDotH > 0.0f ? nDotH : 0.0f, l->shininess);
+	}
+
+	for (int c = 0; c < 3; ++c)
+	{
+		GLfloat v = l->modelAmbient[c] * l->ambient[c] + diffuse[c] * nDotL +
+				l->specular[c] * specular;
+		out[c] = v < 1.0f ? v : 1.0f;
+	}
+}
+
+/* Bounding box of a triangle's pixel centers, clamped to the target */
+static GLuint Bounds(struct Triangle* tri)
+{
+	GLfloat minX = fminf(tri->x[0], fminf(tri->x[1], tri->x[2]));
+	GLfloat maxX = fmaxf(tri->x[0], fmaxf(tri->x[1], tri->x[2]));
+	GLfloat minY = fminf(tri->y[0], fminf(tri->y[1], tri->y[2]));
+	GLfloat maxY = fmaxf(tri->y[0], fmaxf(tri->y[1], tri->y[2]));
+	tri->bounds[0] = (GLint) floorf(fmaxf(minX, 0.0f));
+	tri->bounds[1] = (GLint) floorf(fmaxf(minY, 0.0f));
+	tri->bounds[2] = (GLint) ceilf(fminf(maxX, (GLfloat) g_width));
+	tri->bounds[3] = (GLint) ceilf(fminf(maxY, (GLfloat) g_height));
+	return tri->bounds[0] < tri->bounds[2] && tri->bounds[1] < tri->bounds[3];
+}
+
+/*
+ * Clips a triangle to the near plane, projects what is left to window
+ * coordinates and appends it to out as up to two triangles. Back facing
+ * ones are dropped if cullBack is set, otherwise turned around. coords is
+ * 0 for flat shaded triangles, else where texture coordinates go, one per
+ * triangle appended. Returns the number appended.
+ */
+static size_t EmitTriangle(const struct ClipVertex* v[3],
+		const GLfloat color[3], GLuint cullBack, struct Triangle* out,
+		struct FloorCoords* coords, GLint floorIndex)
+{
+	/* Sutherland-Hodgman against z >= -w leaves at most 4 vertices */
+	struct ClipVertex polygon[4];
+	int n = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		const struct ClipVertex* a = v[i];
+		const struct ClipVertex* b = v[(i + 1) % 3];
+		GLfloat da = a->clip[2] + a->clip[3];
+		GLfloat db = b->clip[2] + b->clip[3];
+		if (da >= 0.0f)
+			polygon[n++] = *a;
+		if ((da >= 0.0f) != (db >= 0.0f))
+		{
+			GLfloat t = da / (da - db);
+			struct ClipVertex* c = &polygon[n++];
+			for (int k = 0; k < 4; ++k)
+				c->clip[k] = a->clip[k] + t * (b->clip[k] - a->clip[k]);
+			c->s = a->s + t * (b->s - a->s);
+			c->t = a->t + t * (b->t - a->t);
+		}
+	}
+
+	GLfloat x[4];
+	GLfloat y[4];
+	GLfloat z[4];
+	GLfloat q[4];
+	for (int i = 0; i < n; ++i)
+	{
+		q[i] = 1.0f / polygon[i].clip[3];
+		x[i] = roundf((polygon[i].clip[0] * q[i] + 1.0f) * 0.5f * g_width *
+				SUBPIXEL) / SUBPIXEL;
+		y[i] = roundf((polygon[i].clip[1] * q[i] + 1.0f) * 0.5f * g_height *
+				SUBPIXEL) / SUBPIXEL;
+		z[i] = (polygon[i].clip[2] * q[i] + 1.0f) * 0.5f;
+	}
+
+	size_t emitted = 0;
+	for (int i = 1; i + 1 < n; ++i)
+	{
+		int corner[3] = { 0, i, i + 1 };
+		GLfloat area = (x[i] - x[0]) * (y[i + 1] - y[0]) -
+				(x[i + 1] - x[0]) * (y[i] - y[0]);
+		if (0.0f == area || (area < 0.0f && cullBack))
+			continue;
+		if (area < 0.0f)
+		{
+			corner[1] = i + 1;
+			corner[2] = i;
+		}
+
+		struct Triangle* tri = &out[emitted];
+		for (int k = 0; k < 3; ++k)
+		{
+			tri->x[k] = x[corner[k]];
+			tri->y[k] = y[corner[k]];
+			tri->z[k] = z[corner[k]];
+			tri->color[k] = color[k];
+		}
+		if (!Bounds(tri))
+			continue;
+
+		tri->floor = -1;
+		if (coords)
+		{
+			struct FloorCoords* fc = &coords[emitted];
+			for (int k = 0; k < 3; ++k)
+			{
+				const struct ClipVertex* p = &polygon[corner[k]];
+				fc->q[k] = q[corner[k]];
+				fc->s[k] = p->s * q[corner[k]];
+				fc->t[k] = p->t * q[corner[k]];
+			}
+			tri->floor = floorIndex + emitted;
+		}
+		++emitted;
+	}
+	return emitted;
+}
+
+static void SetupFloor(const struct Pass* pass, struct Object* object)
+{
+	struct ClipVertex corners[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		GLfloat world[4] = { g_floorQuad[i][2], g_floorQuad[i][3],
+				g_floorQuad[i][4], 1.0f };
+		GLfloat eye[4];
+		Transform(pass->view, world, eye);
+		Transform(pass->projection, eye, corners[i].clip);
+		corners[i].s = g_floorQuad[i][0];
+		corners[i].t = g_floorQuad[i][1];
+	}
+
+	static const GLfloat unused[3];
+	const struct ClipVertex* halves[2][3] = {
+		{ &corners[0], &corners[1], &corners[2] },
+		{ &corners[0], &corners[2], &corners[3] }
+	};
+	for (int h = 0; h < 2; ++h)
+		object->count += EmitTriangle(halves[h], unused, 0,
+				g_triangles + object->first + object->count,
+				g_floorCoords + object->count, object->count);
+}
+
+/*
+ * Places, lights and projects a sphere as RenderSphere() does: scale by
+ * radius, 90 degrees about Y, roll about X, translate. scratch and lit
+ * hold g_maxVertices vertices. GL draws spheres without face culling, so
+ * back faces are only dropped while the near plane leaves the mesh closed
+ * and they cannot show. Like GL's one sided lighting they keep the front
+ * normal's color.
+ */
+static void SetupSphere(const struct Pass* pass, size_t i,
+		struct Object* object, struct ClipVertex* scratch, GLfloat (*lit)[3])
+{
+	const struct Spheres* s = pass->spheres;
+	const struct Mesh* mesh = &g_meshes[s->lod[i]];
+	const GLfloat* diffuse = s->hit[i] ?
+			pass->hitColor : pass->colors[s->colorIdx[i]];
+	GLfloat roll = s->rotationDrawn[i] * (GLfloat) (M_PI / 180.0);
+	GLfloat c = cosf(roll);
+	GLfloat sn = sinf(roll);
+	const GLfloat* m = pass->view;
+	GLuint closed = 1;
+
+	for (GLint k = 0; k < mesh->vertexCount; ++k)
+	{
+		const GLfloat* v = mesh->vertices + 3 * k;
+		GLfloat normal[3] = { v[2], c * v[1] + sn * v[0], sn * v[1] - c * v[0] };
+		GLfloat world[4] = {
+			normal[0] * s->radius[i] + s->xOffset[i],
+			normal[1] * s->radius[i] - 1.0f,
+			normal[2] * s->radius[i] + s->zDrawn[i],
+			1.0f
+		};
+		GLfloat eye[4];
+		Transform(m, world, eye);
+		Transform(pass->projection, eye, scratch[k].clip);
+		if (scratch[k].clip[2] + scratch[k].clip[3] < 0.0f)
+			closed = 0;
+
+		GLfloat eyeNormal[3];
+		for (int r = 0; r < 3; ++r)
+			eyeNormal[r] = m[r] * normal[0] + m[4 + r] * normal[1] +
+					m[8 + r] * normal[2];
+		Normalize(eyeNormal);
+		Light(eye, eyeNormal, diffuse, lit[k]);
+	}
+
+	for (GLsizei t = 0; t < mesh->triangles; ++t)
+	{
+		const GLushort* index = mesh->indices + 3 * t;
+		const struct ClipVertex* v[3] = {
+			&scratch[index[0]], &scratch[index[1]], &scratch[index[2]]
+		};
+		/* Flat shading takes the color of the last vertex */
+		object->count += EmitTriangle(v, lit[index[2]], closed,
+				g_triangles + object->first + object->count, 0, 0);
+	}
+}
+
+static void SetupChunk(void* ctx, size_t first, size_t last)
+{
+	const struct Pass* pass = ctx;
+	size_t self = (size_t) g_maxVertices * ThreadPoolSelf();
+	struct ClipVertex* scratch = g_setupScratch + self;
+	GLfloat (*lit)[3] = g_setupLit + self;
+
+	for (size_t n = first; n < last; ++n)
+	{
+		struct Object* object = &g_objects[n];
+		object->count = 0;
+		if (0 == n)
+			SetupFloor(pass, object);
+		else
+			SetupSphere(pass, pass->index[n - 1], object, scratch, lit);
+
+		GLint bounds[4] = { g_width, g_height, 0, 0 };
+		for (size_t t = 0; t < object->count; ++t)
+		{
+			const struct Triangle* tri = &g_triangles[object->first + t];
+			for (int k = 0; k < 2; ++k)
+			{
+				if (tri->bounds[k] < bounds[k])
+					bounds[k] = tri->bounds[k];
+				if (tri->bounds[k + 2] > bounds[k + 2])
+					bounds[k + 2] = tri->bounds[k + 2];
+			}
+		}
+		for (int k = 0; k < 2; ++k)
+		{
+			object->tiles[k] = bounds[k] / TILE_SIZE;
+			object->tiles[k + 2] = object->count ?
+					(bounds[k + 2] - 1) / TILE_SIZE + 1 : object->tiles[k];
+		}
+	}
+}
+
+/* Sorts objects into the tiles they touch, keeping their order */
+static int Bin(size_t objects)
+{
+	size_t tiles = g_tilesX * g_tilesY;
+	memset(g_binStart, 0, sizeof(size_t) * (tiles + 1));
+	for (size_t n = 0; n < objects; ++n)
+	{
+		const GLint* r = g_objects[n].tiles;
+		for (GLint ty = r[1]; ty < r[3]; ++ty)
+			for (GLint tx = r[0]; tx < r[2]; ++tx)
+				++g_binStart[ty * g_tilesX + tx + 1];
+	}
+	for (size_t t = 0; t < tiles; ++t)
+		g_binStart[t + 1] += g_binStart[t];
+
+	size_t total = g_binStart[tiles];
+	if (total > g_binCapacity)
+	{
+		GLuint* bins = realloc(g_bins, sizeof(GLuint) * total);
+		if (!bins)
+			return -1;
+		g_bins = bins;
+		g_binCapacity = total;
+	}
+
+	/* g_binStart[t] walks to the end of bin t, then is shifted back */
+	for (size_t n = 0; n < objects; ++n)
+	{
+		const GLint* r = g_objects[n].tiles;
+		for (GLint ty = r[1]; ty < r[3]; ++ty)
+			for (GLint tx = r[0]; tx < r[2]; ++tx)
+				g_bins[g_binStart[ty * g_tilesX + tx]++] = n;
+	}
+	memmove(g_binStart + 1, g_binStart, sizeof(size_t) * tiles);
+	g_binStart[0] = 0;
+	return 0;
+}
+
+static void Texel(const struct TextureLevel* level, GLint x, GLint y,
+		GLfloat weight, GLfloat rgb[3])
+{
+	x %= (GLint) level->width;
+	y %= (GLint) level->height;
+	x += x < 0 ? level->width : 0;
+	y += y < 0 ? level->height : 0;
+	const GLfloat* texel = level->texels + 3 * (y * level->width + x);
+	for (int c = 0; c < 3; ++c)
+		rgb[c] += weight * texel[c];
+}
+
+static void Bilinear(const struct TextureLevel* level, GLfloat s, GLfloat t,
+		GLfloat weight, GLfloat rgb[3])
+{
+	GLfloat u = s * level->width - 0.5f;
+	GLfloat v = t * level->height - 0.5f;
+	GLfloat u0 = floorf(u);
+	GLfloat v0 = floorf(v);
+	GLfloat a = u - u0;
+	GLfloat b = v - v0;
+	GLint x = (GLint) u0;
+	GLint y = (GLint) v0;
+	Texel(level, x, y, weight * (1.0f - a) * (1.0f - b), rgb);
+	Texel(level, x + 1, y, weight * a * (1.0f - b), rgb);
+	Texel(level, x, y + 1, weight * (1.0f - a) * b, rgb);
+	Texel(level, x + 1, y + 1, weight * a * b, rgb);
+}
+
+/*
+ * GL_NEAREST when magnified or not mipmapped, else trilinear. rho is the
+ * texel footprint of the pixel on level 0.
+ */
+static void SampleFloor(GLfloat s, GLfloat t, GLfloat rho, GLfloat rgb[3])
+{
+	rgb[0] = rgb[1] = rgb[2] = 0.0f;
+	if (1 == g_levelCount || rho <= 1.0f)
+	{
+		const struct TextureLevel* level = &g_levels[0];
+		Texel(level, (GLint) floorf(s * level->width),
+				(GLint) floorf(t * level->height), 1.0f, rgb);
+		return;
+	}
+
+	GLfloat lambda = log2f(rho);
+	if (lambda >= g_levelCount - 1)
+	{
+		Bilinear(&g_levels[g_levelCount - 1], s, t, 1.0f, rgb);
+		return;
+	}
+	GLint lower = (GLint) lambda;
+	GLfloat blend = lambda - lower;
+	Bilinear(&g_levels[lower], s, t, 1.0f - blend, rgb);
+	Bilinear(&g_levels[lower + 1], s, t, blend, rgb);
+}
+
+/* Value at vertex 0, d/dx and d/dy of an attribute across a triangle */
+static void Plane(const struct Triangle* tri, const GLfloat a[3],
+		GLfloat plane[3])
+{
+	GLfloat x1 = tri->x[1] - tri->x[0];
+	GLfloat y1 = tri->y[1] - tri->y[0];
+	GLfloat x2 = tri->x[2] - tri->x[0];
+	GLfloat y2 = tri->y[2] - tri->y[0];
+	GLfloat a1 = a[1] - a[0];
+	GLfloat a2 = a[2] - a[0];
+	GLfloat area = x1 * y2 - x2 * y1;
+	plane[0] = a[0];
+	plane[1] = (a1 * y2 - a2 * y1) / area;
+	plane[2] = (x1 * a2 - x2 * a1) / area;
+}
+
+/* Shades one covered pixel of a floor triangle */
+static void ShadeFloor(const GLfloat planes[3][3], GLfloat dx, GLfloat dy,
+		size_t pixel)
+{
+	GLfloat q = planes[0][0] + planes[0][1] * dx + planes[0][2] * dy;
+	GLfloat w = 1.0f / q;
+	GLfloat s = (planes[1][0] + planes[1][1] * dx + planes[1][2] * dy) * w;
+	GLfloat t = (planes[2][0] + planes[2][1] * dx + planes[2][2] * dy) * w;
+
+	/* d(s/q) = (ds - s dq) / q, in level 0 texels */
+	GLfloat dsdx = (planes[1][1] - s * planes[0][1]) * w * g_levels[0].width;
+	GLfloat dtdx = (planes[2][1] - t * planes[0][1]) * w * g_levels[0].height;
+	GLfloat dsdy = (planes[1][2] - s * planes[0][2]) * w * g_levels[0].width;
+	GLfloat dtdy = (planes[2][2] - t * planes[0][2]) * w * g_levels[0].height;
+	GLfloat rho = sqrtf(fmaxf(dsdx * dsdx + dtdx * dtdx,
+			dsdy * dsdy + dtdy * dtdy));
+
+	GLfloat rgb[3];
+	SampleFloor(s, t, rho, rgb);
+	for (int c = 0; c < 3; ++c)
+		g_color[c][pixel] = rgb[c];
+}
+
+/* An edge as both triangles sharing it evaluate it */
+struct Edge
+{
+	GLfloat x; /* start, the lower of the two endpoints */
+	GLfloat y;
+	GLfloat dx; /* to the other endpoint */
+	GLfloat dy;
+	GLuint owned; /* 1 if the triangle is to the left, it gets ties */
+};
+
+/*
+ * Rasterizes the part of a triangle inside a tile. Pixels are tested in
+ * groups of 4 along a row, edge functions and depth with SSE2 when
+ * available.
+ */
+static void RasterTriangle(const struct Triangle* tri, const GLint tile[4])
+{
+	GLint x0 = tri->bounds[0] > tile[0] ? tri->bounds[0] : tile[0];
+	GLint y0 = tri->bounds[1] > tile[1] ? tri->bounds[1] : tile[1];
+	GLint x1 = tri->bounds[2] < tile[2] ? tri->bounds[2] : tile[2];
+	GLint y1 = tri->bounds[3] < tile[3] ? tri->bounds[3] : tile[3];
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	x0 &= ~3;
+
+	struct Edge edges[3];
+	for (int e = 0; e < 3; ++e)
+	{
+		int a = e;
+		int b = (e + 1) % 3;
+		GLuint forward = tri->y[a] < tri->y[b] ||
+				(tri->y[a] == tri->y[b] && tri->x[a] < tri->x[b]);
+		int start = forward ? a : b;
+		int end = forward ? b : a;
+		edges[e].x = tri->x[start];
+		edges[e].y = tri->y[start];
+		edges[e].dx = tri->x[end] - tri->x[start];
+		edges[e].dy = tri->y[end] - tri->y[start];
+		edges[e].owned = forward;
+	}
+
+	GLfloat depth[3];
+	Plane(tri, tri->z, depth);
+	GLfloat planes[3][3];
+	if (tri->floor >= 0)
+	{
+		const struct FloorCoords* fc = &g_floorCoords[tri->floor];
+		Plane(tri, fc->q, planes[0]);
+		Plane(tri, fc->s, planes[1]);
+		Plane(tri, fc->t, planes[2]);
+	}
+
+#ifdef SOFTRASTER_SSE2
+	const __m128 lanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	__m128 edgeX[3];
+	__m128 edgeDy[3];
+	for (int e = 0; e < 3; ++e)
+	{
+		edgeX[e] = _mm_set1_ps(edges[e].x);
+		edgeDy[e] = _mm_set1_ps(edges[e].dy);
+	}
+	const __m128 vertexX = _mm_set1_ps(tri->x[0]);
+	const __m128 depthDx = _mm_set1_ps(depth[1]);
+	const __m128 color[3] = {
+		_mm_set1_ps(tri->color[0]),
+		_mm_set1_ps(tri->color[1]),
+		_mm_set1_ps(tri->color[2])
+	};
+
+	for (GLint y = y0; y < y1; ++y)
+	{
+		GLfloat py = y + 0.5f;
+		__m128 row[3];
+		for (int e = 0; e < 3; ++e)
+			row[e] = _mm_set1_ps(edges[e].dx * (py - edges[e].y));
+		__m128 rowDepth = _mm_set1_ps(depth[0] + depth[2] * (py - tri->y[0]));
+		size_t rowStart = (size_t) y * g_stride;
+
+		for (GLint x = x0; x < x1; x += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((GLfloat) x), lanes);
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (int e = 0; e < 3; ++e)
+			{
+				__m128 f = _mm_sub_ps(row[e],
+						_mm_mul_ps(edgeDy[e], _mm_sub_ps(px, edgeX[e])));
+				inside = _mm_and_ps(inside, edges[e].owned ?
+						_mm_cmpge_ps(f, zero) : _mm_cmplt_ps(f, zero));
+			}
+			if (!_mm_movemask_ps(inside))
+				continue;
+
+			GLfloat* depthOut = g_depth + rowStart + x;
+			__m128 z = _mm_add_ps(rowDepth,
+					_mm_mul_ps(depthDx, _mm_sub_ps(px, vertexX)));
+			__m128 old = _mm_load_ps(depthOut);
+			__m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, old));
+			int bits = _mm_movemask_ps(pass);
+			if (!bits)
+				continue;
+			_mm_store_ps(depthOut, _mm_or_ps(_mm_and_ps(pass, z),
+					_mm_andnot_ps(pass, old)));
+
+			if (tri->floor < 0)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					GLfloat* out = g_color[c] + rowStart + x;
+					_mm_store_ps(out, _mm_or_ps(_mm_and_ps(pass, color[c]),
+							_mm_andnot_ps(pass, _mm_load_ps(out))));
+				}
+				continue;
+			}
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if (bits & (1 << lane))
+					ShadeFloor(planes, x + lane + 0.5f - tri->x[0],
+							py - tri->y[0], rowStart + x + lane);
+			}
+		}
+	}
+#else
+	for (GLint y = y0; y < y1; ++y)
+	{
+		GLfloat py = y + 0.5f;
+		GLfloat row[3];
+		for (int e = 0; e < 3; ++e)
+			row[e] = edges[e].dx * (py - edges[e].y);
+		GLfloat rowDepth = depth[0] + depth[2] * (py - tri->y[0]);
+		size_t rowStart = (size_t) y * g_stride;
+
+		for (GLint x = x0; x < x1; ++x)
+		{
+			GLfloat px = x + 0.5f;
+			GLuint inside = 1;
+			for (int e = 0; e < 3 && inside; ++e)
+			{
+				GLfloat f = row[e] - edges[e].dy * (px - edges[e].x);
+				inside = edges[e].owned ? f >= 0.0f : f < 0.0f;
+			}
+			size_t pixel = rowStart + x;
+			GLfloat z = rowDepth + depth[1] * (px - tri->x[0]);
+			if (!inside || !(z < g_depth[pixel]))
+				continue;
+			g_depth[pixel] = z;
+
+			if (tri->floor < 0)
+			{
+				for (int c = 0; c < 3; ++c)
+					g_color[c][pixel] = tri->color[c];
+			}
+			else
+				ShadeFloor(planes, px - tri->x[0], py - tri->y[0], pixel);
+		}
+	}
+#endif
+}
+
+/* Clears, draws and accumulates whole tiles */
+static void TileChunk(void* ctx, size_t first, size_t last)
+{
+	const struct Pass* pass = ctx;
+	for (size_t t = first; t < last; ++t)
+	{
+		GLint tile[4];
+		tile[0] = (t % g_tilesX) * TILE_SIZE;
+		tile[1] = (t / g_tilesX) * TILE_SIZE;
+		tile[2] = tile[0] + TILE_SIZE < (GLint) g_stride ?
+				tile[0] + TILE_SIZE : (GLint) g_stride;
+		tile[3] = tile[1] + TILE_SIZE < (GLint) g_height ?
+				tile[1] + TILE_SIZE : (GLint) g_height;
+
+		for (GLint y = tile[1]; y < tile[3]; ++y)
+		{
+			size_t row = (size_t) y * g_stride;
+			for (GLint x = tile[0]; x < tile[2]; ++x)
+				g_depth[row + x] = 1.0f;
+			for (int c = 0; c < 3; ++c)
+				memset(g_color[c] + row + tile[0], 0,
+						sizeof(GLfloat) * (tile[2] - tile[0]));
+		}
+
+		for (size_t b = g_binStart[t]; b < g_binStart[t + 1]; ++b)
+		{
+			const struct Object* object = &g_objects[g_bins[b]];
+			for (size_t i = 0; i < object->count; ++i)
+				RasterTriangle(&g_triangles[object->first + i], tile);
+		}
+
+		const GLfloat w = pass->weight;
+		for (int c = 0; c < 3; ++c)
+		{
+			for (GLint y = tile[1]; y < tile[3]; ++y)
+			{
+				size_t row = (size_t) y * g_stride;
+				const GLfloat* in = g_color[c] + row;
+				GLfloat* accum = g_accum[c] + row;
+				if (pass->replace)
+				{
+					for (GLint x = tile[0]; x < tile[2]; ++x)
+						accum[x] = w * in[x];
+				}
+				else if (pass->mix)
+				{
+					for (GLint x = tile[0]; x < tile[2]; ++x)
+						accum[x] += w * (in[x] - accum[x]);
+				}
+				else
+				{
+					for (GLint x = tile[0]; x < tile[2]; ++x)
+						accum[x] += w * in[x];
+				}
+			}
+		}
+	}
+}
+
+void SoftRasterPass(const GLdouble projection[16],
+		const GLdouble view[16], const struct Spheres* spheres,
+		const size_t* index, size_t count, const GLfloat colors[][4],
+		const GLfloat hitColor[4], GLfloat weight, GLuint mix)
+{
+	if (!g_width)
+		return;
+
+	struct Pass pass;
+	for (int i = 0; i < 16; ++i)
+	{
+		pass.projection[i] = projection[i];
+		pass.view[i] = view[i];
+	}
+	/* -2 f n / (f - n) over -(f + n) / (f - n) - 1 of a perspective matrix */
+	pass.near = projection[14] / (projection[10] - 1.0);
+	pass.spheres = spheres;
+	pass.index = index;
+	pass.colors = colors;
+	pass.hitColor = hitColor;
+	pass.weight = weight;
+	pass.mix = mix;
+	pass.replace = g_accumEmpty;
+
+	size_t objects = count + 1;
+	if (objects > g_objectCapacity)
+	{
+		struct Object* grown = realloc(g_objects, sizeof(*grown) * objects);
+		if (!grown)
+			goto oom;
+		g_objects = grown;
+		g_objectCapacity = objects;
+	}
+
+	/* Spheres reaching the near plane may clip into twice the triangles */
+	size_t total = 4;
+	g_objects[0].first = 0;
+	g_objects[0].capacity = 4;
+	for (size_t n = 1; n < objects; ++n)
+	{
+		size_t i = index[n - 1];
+		const GLfloat* m = pass.view;
+		GLfloat z = m[2] * spheres->xOffset[i] - m[6] + m[10] * spheres->zDrawn[i] +
+				m[14];
+		size_t capacity = g_meshes[spheres->lod[i]].triangles;
+		if (z + spheres->radius[i] > -pass.near)
+			capacity *= 2;
+		g_objects[n].first = total;
+		g_objects[n].capacity = capacity;
+		total += capacity;
+	}
+	if (total > g_triangleCapacity)
+	{
+		struct Triangle* grown = realloc(g_triangles, sizeof(*grown) * total);
+		if (!grown)
+			goto oom;
+		g_triangles = grown;
+		g_triangleCapacity = total;
+	}
+
+	ThreadPoolFor(objects, SETUP_GRAIN, SetupChunk, &pass);
+	if (Bin(objects))
+		goto oom;
+	ThreadPoolFor(g_tilesX * g_tilesY, 1, TileChunk, &pass);
+	g_accumEmpty = 0;
+	return;
+
+oom:
+	printf("Error: out of memory for software rendered triangles\n");
+}
+
+static void PresentRows(void* ctx, size_t first, size_t last)
+{
+	(void) ctx;
+	for (size_t y = first; y < last; ++y)
+	{
+		GLubyte* out = g_pixels + 4 * y * g_width;
+		for (GLuint x = 0; x < g_width; ++x, out += 4)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				GLfloat v = g_accumEmpty ? 0.0f : g_accum[c][y * g_stride + x];
+				v = v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+				out[c] = (GLubyte) (v * 255.0f + 0.5f);
+			}
+			out[3] = 255;
+		}
+	}
+}
+
+void SoftRasterPresent()
+{
+	if (!g_width)
+		return;
+
+	ThreadPoolFor(g_height, 16, PresentRows, 0);
+
+	glPushAttrib(GL_ENABLE_BIT);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_TEXTURE_2D);
+	glWindowPos2i(0, 0);
+	glDrawPixels(g_width, g_height, GL_RGBA, GL_UNSIGNED_BYTE, g_pixels);
+	glPopAttrib();
+}
+
+void SoftRasterCleanup()
+{
+	FreeTargets();
+	for (GLuint i = 0; i < MAX_LEVELS; ++i)
+	{
+		free(g_levels[i].texels);
+		g_levels[i].texels = 0;
+	}
+	g_levelCount = 0;
+	for (GLint level = 0; level < LOD_LEVELS; ++level)
+	{
+		free(g_meshes[level].vertices);
+		free(g_meshes[level].indices);
+		memset(&g_meshes[level], 0, sizeof(g_meshes[level]));
+	}
+	g_maxVertices = 0;
+	free(g_setupScratch);
+	g_setupScratch = 0;
+	free(g_setupLit);
+	g_setupLit = 0;
+	free(g_objects);
+	g_objects = 0;
+	g_objectCapacity = 0;
+	free(g_triangles);
+	g_triangles = 0;
+	g_triangleCapacity = 0;
+	free(g_bins);
+	g_bins = 0;
+	g_binCapacity = 0;
+}
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Software renderer for the scene, screen tiles rasterized by the thread pool.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SOFTRASTER_H_
+#define SOFTRASTER_H_
+
+#include <stddef.h>
+
+#include <GL/gl.h>
+
+#include "spheres.h"
+
+/*
+ * Material and light the GL path sets up. The light is GL_LIGHT0 with its
+ * default colors: no ambient, white diffuse and specular.
+ */
+struct SoftLighting
+{
+  GLfloat position[4]; /* eye space, as set with an identity modelview */
+  GLfloat modelAmbient[4]; /* GL_LIGHT_MODEL_AMBIENT */
+  GLfloat ambient[4]; /* material */
+  GLfloat specular[4];
+  GLfloat shininess;
+};
+
+/*
+ * Copies what the scene is drawn from. floorQuad holds s, t, x, y, z of
+ * each corner of the floor, s and t scaled by repeatS and repeatT.
+ * texture is width x height texels of channels bytes, 1 (luminance) or 4
+ * (RGBA). With mipmap set it is minified trilinearly like
+ * GL_LINEAR_MIPMAP_LINEAR, otherwise it is always sampled GL_NEAREST.
+ * There is no anisotropic filtering, as with a GL_TEXTURE_MAX_ANISOTROPY_EXT
+ * of 1.
+ * Call after ThreadPoolInit(), sphere setup scratch is allocated per thread.
+ * Returns 0 on success, -1 if out of memory.
+ */
+extern int SoftRasterInit(const struct SoftLighting* lighting,
+		const GLfloat floorQuad[4][5], GLfloat repeatS, GLfloat repeatT,
+		const GLubyte* texture, GLuint width, GLuint height, GLuint channels,
+		GLuint mipmap);
+
+/*
+ * (Re)allocates the color, depth and accumulation buffers if the size
+ * changed. Returns 1 if the software renderer is in use, 0 if disabled or
+ * out of memory.
+ */
+extern GLuint SoftRasterConfigure(GLuint enable, GLuint width, GLuint height);
+
+/* Empties the accumulation buffer, the next pass replaces it */
+extern void SoftRasterClear();
+
+/*
+ * Renders the floor and the count spheres listed in index, at their zDrawn,
+ * rotationDrawn and lod, with the column major projection and view
+ * matrices accPerspectiveMatrices() gives. Sphere diffuse colors are
+ * colors[colorIdx], or hitColor while hit. The pass is then added to the
+ * accumulation buffer with weight, or mixed in as AccumMix() does if mix
+ * is set. Spheres are lit per vertex and flat shaded by the last vertex of
+ * each triangle, as glShadeModel(GL_FLAT) does.
+ */
+extern void SoftRasterPass(const GLdouble projection[16],
+		const GLdouble view[16], const struct Spheres* spheres,
+		const size_t* index, size_t count, const GLfloat colors[][4],
+		const GLfloat hitColor[4], GLfloat weight, GLuint mix);
+
+/*
+ * Draws the accumulation buffer to the current draw buffer with
+ * glDrawPixels(), the only GL call the renderer makes.
+ */
+extern void SoftRasterPresent();
+
+extern void SoftRasterCleanup();
+
+#endif /* SOFTRASTER_H_ */
@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Checks the software renderer against GL, capturing the same frames from
+ * both.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*
+ * Frames captured from each renderer. With this seed spheres fly through
+ * the near plane from the third frame on. The capture queue holds 8, so
+ * no frame can be dropped.
+ */
+#define SOFT_TEST_FRAMES "8"
+
+/* Largest mean difference per channel of any frame, out of 255 */
+#define SOFT_TEST_MAX_DIFF 1.0
+
+/*
+ * Runs demo headless with renderer, capturing to path. GL filters the
+ * floor without anisotropy, as the software renderer does.
+ * Returns 0 on success, -1 on failure.
+ */
+static int Render(const char* demo, const char* renderer, const char* path)
+{
+	char* const args[] = {
+		(char*) demo, "--headless", "--seed", "1", "--size", "256x256",
+		"--spheres", "20", "--aa", "4", "--frames", SOFT_TEST_FRAMES,
+		"--warmup", "0", "--aniso", "1", "--renderer", (char*) renderer,
+		"--capture", (char*) path, 0
+	};
+
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0)
+		return -1;
+	if (0 == pid)
+	{
+		execv(demo, args);
+		_exit(127);
+	}
+
+	int status = 0;
+	if (waitpid(pid, &status, 0) < 0)
+		return -1;
+	return WIFEXITED(status) && 0 == WEXITSTATUS(status) ? 0 : -1;
+}
+
+/*
+ * Reads the next binary PPM frame of f into a new buffer of *bytes.
+ * Returns 0 at the end of the file or on a malformed frame.
+ */
+static unsigned char* ReadFrame(FILE* f, size_t* bytes)
+{
+	unsigned width = 0;
+	unsigned height = 0;
+	unsigned max = 0;
+	if (3 != fscanf(f, "P6 %u %u %u", &width, &height, &max) ||
+		EOF == fgetc(f) || max != 255)
+		return 0;
+
+	*bytes = 3 * (size_t) width * height;
+	unsigned char* frame = malloc(*bytes);
+	if (frame && fread(frame, 1, *bytes, f) != *bytes)
+	{
+		free(frame);
+		return 0;
+	}
+	return frame;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		printf("Usage: %s DEMO\n", argv[0]);
+		return 1;
+	}
+
+	const char* glPath = "softraster_test_gl.ppm";
+	const char* softPath = "softraster_test_soft.ppm";
+	if (Render(argv[1], "gl", glPath) || Render(argv[1], "soft", softPath))
+	{
+		printf("Error: %s failed to render\n", argv[1]);
+		return 1;
+	}
+
+	FILE* gl = fopen(glPath, "rb");
+	FILE* soft = fopen(softPath, "rb");
+	if (!gl || !soft)
+	{
+		printf("Error: cannot open the captures\n");
+		return 1;
+	}
+
+	int failed = 0;
+	unsigned frames = 0;
+	printf("frame,mean_diff,max_diff\n");
+	for (;;)
+	{
+		size_t bytes = 0;
+		size_t softBytes = 0;
+		unsigned char* a = ReadFrame(gl, &bytes);
+		unsigned char* b = ReadFrame(soft, &softBytes);
+		if (!a || !b || bytes != softBytes)
+		{
+			free(a);
+			free(b);
+			break;
+		}
+
+		double sum = 0.0;
+		int max = 0;
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			int d = abs(a[i] - b[i]);
+			sum += d;
+			max = d > max ? d : max;
+		}
+		double mean = sum / bytes;
+		printf("%u,%.3f,%d\n", frames, mean, max);
+		if (mean > SOFT_TEST_MAX_DIFF)
+		{
+			printf("Error: frame %u differs by %.3f on average\n", frames, mean);
+			failed = 1;
+		}
+		++frames;
+		free(a);
+		free(b);
+	}
+	fclose(gl);
+	fclose(soft);
+
+	if (frames != (unsigned) atoi(SOFT_TEST_FRAMES))
+	{
+		printf("Error: compared %u frames, expected %s\n", frames,
+				SOFT_TEST_FRAMES);
+		failed = 1;
+	}
+	return failed;
+}
@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Unit sphere meshes in VBOs, built once per tessellation.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "spheremesh.h"
+
+#define SPHERE_MESH_CACHE_MAX 16
+
+static struct SphereMesh g_meshes[SPHERE_MESH_CACHE_MAX];
+static int g_meshCount;
+
+GLsizei SphereMeshTessellate(GLint slices, GLint stacks,
+		GLfloat** verticesOut, GLint* vertexCountOut, GLushort** indicesOut)
+{
+	/* A (stacks + 1) x (slices + 1) grid, the seam column is duplicated */
+	GLint columns = slices + 1;
+	GLint vertexCount = (stacks + 1) * columns;
+	assert(slices >= 3 && stacks >= 2 && vertexCount <= 65536);
+
+	/* Two triangles per quad, minus the degenerate ones at the poles */
+	GLsizei indexMax = 6 * slices * stacks;
+	GLfloat* vertices = malloc(sizeof(GLfloat) * 3 * vertexCount);
+	GLushort* indices = malloc(sizeof(GLushort) * indexMax);
+	if (!vertices || !indices)
+	{
+		free(vertices);
+		free(indices);
+		*verticesOut = 0;
+		*vertexCountOut = 0;
+		*indicesOut = 0;
+		return 0;
+	}
+
+	GLfloat* v = vertices;
+	for (GLint i = 0; i <= stacks; ++i)
+	{
+		GLdouble phi = M_PI * i / stacks;
+		for (GLint j = 0; j <= slices; ++j)
+		{
+			GLdouble theta = 2.0 * M_PI * j / slices;
+			*v++ = sin(phi) * cos(theta);
+			*v++ = sin(phi) * sin(theta);
+			*v++ = cos(phi);
+		}
+	}
+
+	GLsizei count = 0;
+	for (GLint i = 0; i < stacks; ++i)
+	{
+		for (GLint j = 0; j < slices; ++j)
+		{
+			GLushort a = i * columns + j;
+			GLushort b = a + columns;
+			if (i != 0)
+			{
+				indices[count++] = a;
+				indices[count++] = b;
+				indices[count++] = a + 1;
+			}
+			if (i != stacks - 1)
+			{
+				indices[count++] = a + 1;
+				indices[count++] = b;
+				indices[count++] = b + 1;
+			}
+		}
+	}
+
+	*verticesOut = vertices;
+	*vertexCountOut = vertexCount;
+	*indicesOut = indices;
+	return count;
+}
+
+/* Returns 0 on success, -1 if out of memory */
+static int BuildMesh(struct SphereMesh* mesh, GLint slices, GLint stacks)
+{
+	GLfloat* vertices;
+	GLint vertexCount;
+	GLushort* indices;
+	GLsizei count = SphereMeshTessellate(slices, stacks, &vertices,
+			&vertexCount, &indices);
+	if (!count)
+		return -1;
+
+	mesh->slices = slices;
+	mesh->stacks = stacks;
+	mesh->indexCount = count;
+
+	glGenBuffers(1, &mesh->vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * vertexCount,
+			vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &mesh->indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * count,
+			indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	free(indices);
+	free(vertices);
+	return 0;
+}
+
+const struct SphereMesh* SphereMeshGet(GLint slices, GLint stacks)
+{
+	for (int i = 0; i < g_meshCount; ++i)
+	{
+		if (g_meshes[i].slices == slices && g_meshes[i].stacks == stacks)
+			return &g_meshes[i];
+	}
+
+	assert(g_meshCount < SPHERE_MESH_CACHE_MAX);
+	struct SphereMesh* mesh = &g_meshes[g_meshCount];
+	if (BuildMesh(mesh, slices, stacks))
+		return 0;
+	++g_meshCount;
+	return mesh;
+}
+
+void SphereMeshDraw(const struct SphereMesh* mesh)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, 0);
+	glNormalPointer(GL_FLOAT, 0, 0);
+
+	glDrawElements(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_SHORT, 0);
+
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SphereMeshCleanup()
+{
+	for (int i = 0; i < g_meshCount; ++i)
+	{
+		glDeleteBuffers(1, &g_meshes[i].vertexBuffer);
+		glDeleteBuffers(1, &g_meshes[i].indexBuffer);
+	}
+	g_meshCount = 0;
+}
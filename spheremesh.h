@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Unit sphere meshes in VBOs, built once per tessellation.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SPHEREMESH_H_
+#define SPHEREMESH_H_
+
+#include <GL/gl.h>
+
+struct SphereMesh
+{
+	GLint slices;
+	GLint stacks;
+	GLuint vertexBuffer; /* unit sphere, so positions double as normals */
+	GLuint indexBuffer; /* GL_UNSIGNED_SHORT triangles */
+	GLsizei indexCount;
+};
+
+/*
+ * Returns the cached mesh for this tessellation, building it on first use.
+ * Same layout as glutSolidSphere(): poles on Z, slices around Z. Needs a
+ * current context. Returns 0 if out of memory.
+ */
+extern const struct SphereMesh* SphereMeshGet(GLint slices, GLint stacks);
+
+/*
+ * The unit sphere SphereMeshGet() uploads, in malloc()ed arrays the caller
+ * frees: 3 floats per vertex and 3 indices per triangle, counterclockwise
+ * seen from outside. Returns the index count, or 0 with the arrays set to
+ * 0 if out of memory. No context needed.
+ */
+extern GLsizei SphereMeshTessellate(GLint slices, GLint stacks,
+		GLfloat** vertices, GLint* vertexCount, GLushort** indices);
+
+/*
+ * Draws a unit sphere, scale the modelview for other radii. GL_RESCALE_NORMAL
+ * should be enabled so scaled normals stay unit length for lighting.
+ */
+extern void SphereMeshDraw(const struct SphereMesh* mesh);
+
+extern void SphereMeshCleanup();
+
+#endif /* SPHEREMESH_H_ */
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Structure-of-arrays sphere set and its batched time step.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPHERES_X86 1
+#include <immintrin.h>
+#endif
+
+#include "spheres.h"
+
+/* Degrees of roll per unit of distance on a unit sphere */
+static const GLfloat g_degPerRad = 180.0 / M_PI;
+
+/* 32 byte aligned and padded to 8 elements for the vector loops */
+static void* AllocArray(size_t count, size_t size)
+{
+	size_t bytes = ((count + 7) & ~(size_t) 7) * size;
+	void* rv = aligned_alloc(32, bytes ? bytes : 32);
+	if (rv)
+		memset(rv, 0, bytes);
+	return rv;
+}
+
+int SpheresAlloc(struct Spheres* spheres, size_t count)
+{
+	SpheresFree(spheres);
+
+	spheres->hit = AllocArray(count, sizeof(GLuint));
+	spheres->zDistance = AllocArray(count, sizeof(GLfloat));
+	spheres->zSpeed = AllocArray(count, sizeof(GLfloat));
+	spheres->zSpeedDefault = AllocArray(count, sizeof(GLfloat));
+	spheres->rotation = AllocArray(count, sizeof(GLfloat));
+	spheres->radius = AllocArray(count, sizeof(GLfloat));
+	spheres->xOffset = AllocArray(count, sizeof(GLfloat));
+	spheres->colorIdx = AllocArray(count, sizeof(GLint));
+	spheres->lod = AllocArray(count, sizeof(GLint));
+	spheres->zDistancePrev = AllocArray(count, sizeof(GLfloat));
+	spheres->zDrawn = AllocArray(count, sizeof(GLfloat));
+	spheres->rotationDrawn = AllocArray(count, sizeof(GLfloat));
+	spheres->zDrawnLast = AllocArray(count, sizeof(GLfloat));
+
+	if (!spheres->hit || !spheres->zDistance || !spheres->zSpeed ||
+		!spheres->zSpeedDefault || !spheres->rotation || !spheres->radius ||
+		!spheres->xOffset || !spheres->colorIdx || !spheres->lod ||
+		!spheres->zDistancePrev || !spheres->zDrawn || !spheres->rotationDrawn ||
+		!spheres->zDrawnLast)
+	{
+		SpheresFree(spheres);
+		return -1;
+	}
+
+	spheres->count = count;
+	return 0;
+}
+
+void SpheresFree(struct Spheres* spheres)
+{
+	free(spheres->hit);
+	free(spheres->zDistance);
+	free(spheres->zSpeed);
+	free(spheres->zSpeedDefault);
+	free(spheres->rotation);
+	free(spheres->radius);
+	free(spheres->xOffset);
+	free(spheres->colorIdx);
+	free(spheres->lod);
+	free(spheres->zDistancePrev);
+	free(spheres->zDrawn);
+	free(spheres->rotationDrawn);
+	free(spheres->zDrawnLast);
+	memset(spheres, 0, sizeof(*spheres));
+}
+
+/*
+ * The vector versions below must stay bit for bit identical to this one:
+ * the same float operations in the same order, no FMA.
+ */
+static void MoveScalar(struct Spheres* s, size_t first, size_t last,
+		GLfloat factor)
+{
+	for (size_t i = first; i < last; ++i)
+	{
+		GLfloat z = s->zDistance[i] - s->zSpeed[i] * factor;
+		if (z < SPHERES_Z_WRAP)
+			z = 0.0f;
+		s->zDistance[i] = z;
+		s->rotation[i] = (z / s->radius[i]) * g_degPerRad;
+	}
+}
+
+#ifdef SPHERES_X86
+static size_t MoveSse2(struct Spheres* s, size_t first, size_t last,
+		GLfloat factor)
+{
+	const __m128 vFactor = _mm_set1_ps(factor);
+	const __m128 vWrap = _mm_set1_ps(SPHERES_Z_WRAP);
+	const __m128 vDeg = _mm_set1_ps(g_degPerRad);
+
+	size_t i = first;
+	for (; i + 4 <= last; i += 4)
+	{
+		__m128 step = _mm_mul_ps(_mm_loadu_ps(s->zSpeed + i), vFactor);
+		__m128 z = _mm_sub_ps(_mm_loadu_ps(s->zDistance + i), step);
+		z = _mm_andnot_ps(_mm_cmplt_ps(z, vWrap), z);
+		__m128 rot = _mm_mul_ps(_mm_div_ps(z, _mm_loadu_ps(s->radius + i)), vDeg);
+
+		_mm_storeu_ps(s->zDistance + i, z);
+		_mm_storeu_ps(s->rotation + i, rot);
+	}
+	return i;
+}
+
+__attribute__((target("avx")))
+static size_t MoveAvx(struct Spheres* s, size_t first, size_t last,
+		GLfloat factor)
+{
+	const __m256 vFactor = _mm256_set1_ps(factor);
+	const __m256 vWrap = _mm256_set1_ps(SPHERES_Z_WRAP);
+	const __m256 vDeg = _mm256_set1_ps(g_degPerRad);
+
+	size_t i = first;
+	for (; i + 8 <= last; i += 8)
+	{
+		__m256 step = _mm256_mul_ps(_mm256_loadu_ps(s->zSpeed + i), vFactor);
+		__m256 z = _mm256_sub_ps(_mm256_loadu_ps(s->zDistance + i), step);
+		z = _mm256_andnot_ps(_mm256_cmp_ps(z, vWrap, _CMP_LT_OQ), z);
+		__m256 rot = _mm256_mul_ps(
+				_mm256_div_ps(z, _mm256_loadu_ps(s->radius + i)), vDeg);
+
+		_mm256_storeu_ps(s->zDistance + i, z);
+		_mm256_storeu_ps(s->rotation + i, rot);
+	}
+	return i;
+}
+#endif
+
+enum TimeStepIsa { ISA_SCALAR = 0, ISA_SSE2, ISA_AVX };
+
+static enum TimeStepIsa g_isa = ISA_SCALAR;
+static pthread_once_t g_isaOnce = PTHREAD_ONCE_INIT;
+
+static void DetectIsaOnce()
+{
+#ifdef SPHERES_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+		g_isa = ISA_AVX;
+	else if (__builtin_cpu_supports("sse2"))
+		g_isa = ISA_SSE2;
+#endif
+}
+
+/* Thread pool workers step spheres too, so detect once for all threads */
+static enum TimeStepIsa DetectIsa()
+{
+	pthread_once(&g_isaOnce, DetectIsaOnce);
+	return g_isa;
+}
+
+void SpheresTimeStep(struct Spheres* spheres, size_t first, size_t last,
+		GLfloat factor, GLuint now, GLuint hitDuration)
+{
+	/* Hits are rare, so expiry stays a cheap scalar scan */
+	for (size_t i = first; i < last; ++i)
+	{
+		if (spheres->hit[i] && (now - spheres->hit[i]) > hitDuration)
+		{
+			spheres->hit[i] = 0;
+			spheres->zSpeed[i] = spheres->zSpeedDefault[i];
+		}
+	}
+
+	memcpy(spheres->zDistancePrev + first, spheres->zDistance + first,
+			sizeof(GLfloat) * (last - first));
+
+	size_t done = first;
+#ifdef SPHERES_X86
+	switch (DetectIsa())
+	{
+		case ISA_AVX:
+			done = MoveAvx(spheres, first, last, factor);
+			break;
+		case ISA_SSE2:
+			done = MoveSse2(spheres, first, last, factor);
+			break;
+		default:
+			break;
+	}
+#endif
+	MoveScalar(spheres, done, last, factor);
+}
+
+void SpheresInterpolate(struct Spheres* spheres, size_t first,
+		size_t last, GLfloat alpha, GLfloat hitLag)
+{
+	for (size_t i = first; i < last; ++i)
+	{
+		GLfloat prev = spheres->zDistancePrev[i];
+		GLfloat z = spheres->zDistance[i];
+
+		/* Spheres only move towards -z, anything else is a wrap */
+		if (z <= prev)
+			z = prev + (z - prev) * alpha;
+		if (spheres->hit[i])
+			z += spheres->zSpeed[i] * hitLag;
+
+		spheres->zDrawn[i] = z;
+		spheres->rotationDrawn[i] = (z / spheres->radius[i]) * g_degPerRad;
+	}
+}
+
+const char* SpheresTimeStepIsa()
+{
+	switch (DetectIsa())
+	{
+		case ISA_AVX:
+			return "AVX";
+		case ISA_SSE2:
+			return "SSE2";
+		default:
+			return "scalar";
+	}
+}
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Structure-of-arrays sphere set and its batched time step.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SPHERES_H_
+#define SPHERES_H_
+
+#include <stddef.h>
+
+#include <GL/gl.h>
+
+/* Spheres roll back to z = 0 once they pass this distance */
+#define SPHERES_Z_WRAP -48.0f
+
+struct Spheres
+{
+  size_t count;
+  GLuint *hit; /* tick time of the last hit in milliseconds, 0 if not hit */
+  GLfloat *zDistance;
+  GLfloat *zSpeed; /* How fast to move on Z */
+  GLfloat *zSpeedDefault;
+  GLfloat *rotation; /* X rotation (roll effect) */
+  GLfloat *radius;
+  GLfloat *xOffset;
+  GLint *colorIdx; /* see g_colors[] */
+  GLint *lod; /* current level of detail, see lod.h */
+  GLfloat *zDistancePrev; /* zDistance before the last time step */
+  GLfloat *zDrawn; /* where to draw, see SpheresInterpolate() */
+  GLfloat *rotationDrawn;
+  GLfloat *zDrawnLast; /* zDrawn as of the previous frame, for motion vectors */
+};
+
+/* Frees any previous arrays and allocates count zeroed spheres */
+extern int SpheresAlloc(struct Spheres* spheres, size_t count);
+extern void SpheresFree(struct Spheres* spheres);
+
+/*
+ * Advances spheres [first, last) by zSpeed * factor, keeping the old
+ * zDistance in zDistancePrev. Hits older than hitDuration are cleared
+ * first. Uses AVX or SSE2 when available.
+ */
+extern void SpheresTimeStep(struct Spheres* spheres, size_t first, size_t last,
+		GLfloat factor, GLuint now, GLuint hitDuration);
+
+/*
+ * Sets zDrawn and rotationDrawn of spheres [first, last) to alpha of the
+ * way from zDistancePrev to zDistance, 0 <= alpha <= 1. Spheres that
+ * wrapped in the last step are drawn where they are now. Hit spheres are
+ * drawn hitLag steps further back in time, for motion blur.
+ */
+extern void SpheresInterpolate(struct Spheres* spheres, size_t first,
+		size_t last, GLfloat alpha, GLfloat hitLag);
+
+/* Name of the SpheresTimeStep() implementation picked for this CPU */
+extern const char* SpheresTimeStepIsa();
+
+#endif /* SPHERES_H_ */
@@ -49,6 +49,7 @@
 /* #include <GL/glut.h> */
 #include "accpersp.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "jitter.h"
 
@@ -59,6 +60,96 @@
 
 #define PI_ 3.14159265358979323846
 
+/* Rick Ramstetter: accFrustumMatrices() and friends are the math of
+ * accFrustum() and accPerspective() without a GL context. They take the
+ * viewport explicitly and only write the caller's arrays, so they can run
+ * on any thread.
+ */
+void accFrustumMatrices(GLdouble left, GLdouble right, GLdouble bottom,
+   GLdouble top, GLdouble near, GLdouble far, GLdouble pixdx,
+   GLdouble pixdy, GLdouble eyedx, GLdouble eyedy, GLdouble focus,
+   const GLint viewport[4], GLdouble projection[16], GLdouble view[16])
+{
+   GLdouble dx, dy, l, r, b, t;
+
+   dx = -(pixdx*(right - left)/(GLdouble) viewport[2] + eyedx*near/focus);
+   dy = -(pixdy*(top - bottom)/(GLdouble) viewport[3] + eyedy*near/focus);
+   l = left + dx;
+   r = right + dx;
+   b = bottom + dy;
+   t = top + dy;
+
+   /* glFrustum (l, r, b, t, near, far) */
+   memset(projection, 0, sizeof(GLdouble) * 16);
+   projection[0] = 2.0*near/(r - l);
+   projection[5] = 2.0*near/(t - b);
+   projection[8] = (r + l)/(r - l);
+   projection[9] = (t + b)/(t - b);
+   projection[10] = -(far + near)/(far - near);
+   projection[11] = -1.0;
+   projection[14] = -2.0*far*near/(far - near);
+
+   /* glTranslatef (-eyedx, -eyedy, 0.0) */
+   memset(view, 0, sizeof(GLdouble) * 16);
+   view[0] = view[5] = view[10] = view[15] = 1.0;
+   view[12] = -eyedx;
+   view[13] = -eyedy;
+}
+
+void accFrustumMatricesf(GLdouble left, GLdouble right, GLdouble bottom,
+   GLdouble top, GLdouble near, GLdouble far, GLdouble pixdx,
+   GLdouble pixdy, GLdouble eyedx, GLdouble eyedy, GLdouble focus,
+   const GLint viewport[4], GLfloat projection[16], GLfloat view[16])
+{
+   GLdouble p[16], v[16];
+   int i;
+
+   accFrustumMatrices(left, right, bottom, top, near, far,
+                      pixdx, pixdy, eyedx, eyedy, focus, viewport, p, v);
+   for (i = 0; i < 16; i++) {
+      projection[i] = (GLfloat) p[i];
+      view[i] = (GLfloat) v[i];
+   }
+}
+
+/* Near plane window of gluPerspective (fovy, aspect, near, far) */
+static void perspectiveBounds(GLdouble fovy, GLdouble aspect,
+   GLdouble near, GLdouble *right, GLdouble *top)
+{
+   GLdouble fov2;
+
+   fov2 = ((fovy*PI_) / 180.0) / 2.0;
+
+   *top = near / (cos(fov2) / sin(fov2));
+   *right = *top * aspect;
+}
+
+void accPerspectiveMatrices(GLdouble fovy, GLdouble aspect,
+   GLdouble near, GLdouble far, GLdouble pixdx, GLdouble pixdy,
+   GLdouble eyedx, GLdouble eyedy, GLdouble focus,
+   const GLint viewport[4], GLdouble projection[16], GLdouble view[16])
+{
+   GLdouble right, top;
+
+   perspectiveBounds(fovy, aspect, near, &right, &top);
+   accFrustumMatrices(-right, right, -top, top, near, far,
+                      pixdx, pixdy, eyedx, eyedy, focus,
+                      viewport, projection, view);
+}
+
+void accPerspectiveMatricesf(GLdouble fovy, GLdouble aspect,
+   GLdouble near, GLdouble far, GLdouble pixdx, GLdouble pixdy,
+   GLdouble eyedx, GLdouble eyedy, GLdouble focus,
+   const GLint viewport[4], GLfloat projection[16], GLfloat view[16])
+{
+   GLdouble right, top;
+
+   perspectiveBounds(fovy, aspect, near, &right, &top);
+   accFrustumMatricesf(-right, right, -top, top, near, far,
+                       pixdx, pixdy, eyedx, eyedy, focus,
+                       viewport, projection, view);
+}
+
 /* accFrustum()
  * The first 6 arguments are identical to the glFrustum() call.
  *  
@@ -78,24 +169,19 @@ void accFrustum(GLdouble left, GLdouble right, GLdouble bottom,
    GLdouble top, GLdouble near, GLdouble far, GLdouble pixdx, 
    GLdouble pixdy, GLdouble eyedx, GLdouble eyedy, GLdouble focus)
 {
-   GLdouble xwsize, ywsize; 
-   GLdouble dx, dy;
+   GLdouble projection[16], view[16];
    GLint viewport[4];
 
    glGetIntegerv (GL_VIEWPORT, viewport);
-	
-   xwsize = right - left;
-   ywsize = top - bottom;
-	
-   dx = -(pixdx*xwsize/(GLdouble) viewport[2] + eyedx*near/focus);
-   dy = -(pixdy*ywsize/(GLdouble) viewport[3] + eyedy*near/focus);
-	
+
+   accFrustumMatrices(left, right, bottom, top, near, far,
+                      pixdx, pixdy, eyedx, eyedy, focus,
+                      viewport, projection, view);
+
    glMatrixMode(GL_PROJECTION);
-   glLoadIdentity();
-   glFrustum (left + dx, right + dx, bottom + dy, top + dy, near, far);
+   glLoadMatrixd(projection);
    glMatrixMode(GL_MODELVIEW);
-   glLoadIdentity();
-   glTranslatef (-eyedx, -eyedy, 0.0);
+   glLoadMatrixd(view);
 }
 
 /* accPerspective()
@@ -115,18 +201,80 @@ void accPerspective(GLdouble fovy, GLdouble aspect,
    GLdouble near, GLdouble far, GLdouble pixdx, GLdouble pixdy, 
    GLdouble eyedx, GLdouble eyedy, GLdouble focus)
 {
-   GLdouble fov2,left,right,bottom,top;
+   GLdouble right, top;
 
-   fov2 = ((fovy*PI_) / 180.0) / 2.0;
+   perspectiveBounds(fovy, aspect, near, &right, &top);
 
-   top = near / (cos(fov2) / sin(fov2));
-   bottom = -top;
+   accFrustum (-right, right, -top, top, near, far,
+               pixdx, pixdy, eyedx, eyedy, focus);
+}
 
-   right = top * aspect;
-   left = -right;
+int accMatrixCacheUpdate(accMatrixCache *cache, GLdouble fovy,
+   GLdouble aspect, GLdouble near, GLdouble far, GLdouble focus,
+   const GLint viewport[4], const GLfloat *jitter, const GLfloat *eyeJitter,
+   int stride, int count, GLdouble pixScale, GLdouble eyeScale)
+{
+   int i;
 
-   accFrustum (left, right, bottom, top, near, far,
-               pixdx, pixdy, eyedx, eyedy, focus);
+   if (cache->projection && cache->fovy == fovy &&
+       cache->aspect == aspect && cache->near == near &&
+       cache->far == far && cache->focus == focus &&
+       cache->pixScale == pixScale && cache->eyeScale == eyeScale &&
+       memcmp(cache->viewport, viewport, sizeof(cache->viewport)) == 0 &&
+       cache->jitter == jitter && cache->eyeJitter == eyeJitter &&
+       cache->stride == stride && cache->count == count)
+      return 0;
+
+   if (count > cache->capacity) {
+      free(cache->projection);
+      free(cache->modelview);
+      cache->projection = malloc(sizeof(GLdouble) * 16 * count);
+      cache->modelview = malloc(sizeof(GLdouble) * 16 * count);
+      cache->capacity = count;
+      if (!cache->projection || !cache->modelview) {
+         accMatrixCacheFree(cache);
+         return -1;
+      }
+   }
+
+   cache->fovy = fovy;
+   cache->aspect = aspect;
+   cache->near = near;
+   cache->far = far;
+   cache->focus = focus;
+   cache->pixScale = pixScale;
+   cache->eyeScale = eyeScale;
+   memcpy(cache->viewport, viewport, sizeof(cache->viewport));
+   cache->jitter = jitter;
+   cache->eyeJitter = eyeJitter;
+   cache->stride = stride;
+   cache->count = count;
+
+   for (i = 0; i < count; i++)
+      accPerspectiveMatrices(fovy, aspect, near, far,
+                             pixScale * jitter[stride * i],
+                             pixScale * jitter[stride * i + 1],
+                             eyeScale * eyeJitter[stride * i],
+                             eyeScale * eyeJitter[stride * i + 1],
+                             focus, viewport,
+                             cache->projection + 16 * i,
+                             cache->modelview + 16 * i);
+   return 1;
+}
+
+void accMatrixCacheLoad(const accMatrixCache *cache, int sample)
+{
+   glMatrixMode(GL_PROJECTION);
+   glLoadMatrixd(cache->projection + 16 * sample);
+   glMatrixMode(GL_MODELVIEW);
+   glLoadMatrixd(cache->modelview + 16 * sample);
+}
+
+void accMatrixCacheFree(accMatrixCache *cache)
+{
+   free(cache->projection);
+   free(cache->modelview);
+   memset(cache, 0, sizeof(*cache));
 }
 
 /*  Initialize lighting and other values.
@@ -81,4 +81,75 @@ extern void accPerspective(GLdouble fovy, GLdouble aspect,
    GLdouble near, GLdouble far, GLdouble pixdx, GLdouble pixdy,
    GLdouble eyedx, GLdouble eyedy, GLdouble focus);
 
+/* accFrustumMatrices()
+ * Rick Ramstetter: accFrustum() without a GL context. The viewport is
+ * passed in instead of queried, and the matrices accFrustum() would load
+ * are written to projection and view, column major as glLoadMatrixd()
+ * takes them. view is the eye translation, load it into GL_MODELVIEW.
+ * Reentrant; nothing but the output arrays is written.
+ */
+extern void accFrustumMatrices(GLdouble left, GLdouble right,
+   GLdouble bottom, GLdouble top, GLdouble near, GLdouble far,
+   GLdouble pixdx, GLdouble pixdy, GLdouble eyedx, GLdouble eyedy,
+   GLdouble focus, const GLint viewport[4],
+   GLdouble projection[16], GLdouble view[16]);
+
+/* As accFrustumMatrices(), computed in double and stored as float */
+extern void accFrustumMatricesf(GLdouble left, GLdouble right,
+   GLdouble bottom, GLdouble top, GLdouble near, GLdouble far,
+   GLdouble pixdx, GLdouble pixdy, GLdouble eyedx, GLdouble eyedy,
+   GLdouble focus, const GLint viewport[4],
+   GLfloat projection[16], GLfloat view[16]);
+
+/* accPerspectiveMatrices()
+ * accPerspective() without a GL context, see accFrustumMatrices().
+ */
+extern void accPerspectiveMatrices(GLdouble fovy, GLdouble aspect,
+   GLdouble near, GLdouble far, GLdouble pixdx, GLdouble pixdy,
+   GLdouble eyedx, GLdouble eyedy, GLdouble focus,
+   const GLint viewport[4], GLdouble projection[16], GLdouble view[16]);
+
+extern void accPerspectiveMatricesf(GLdouble fovy, GLdouble aspect,
+   GLdouble near, GLdouble far, GLdouble pixdx, GLdouble pixdy,
+   GLdouble eyedx, GLdouble eyedy, GLdouble focus,
+   const GLint viewport[4], GLfloat projection[16], GLfloat view[16]);
+
+/* accMatrixCache
+ * Rick Ramstetter: the projection and modelview matrices accPerspective()
+ * would load for every sample of a jitter table, so a pass only needs two
+ * glLoadMatrixd() calls. Sample i uses pixdx = pixScale * jitter[stride * i],
+ * pixdy = pixScale * jitter[stride * i + 1], and eyedx, eyedy the same from
+ * eyeJitter with eyeScale. Matrices are column major, sample i at [16 * i].
+ *
+ * Zero initialize before the first accMatrixCacheUpdate().
+ */
+typedef struct {
+   GLdouble fovy, aspect, near, far, focus;
+   GLdouble pixScale, eyeScale;
+   GLint viewport[4];
+   const GLfloat *jitter; /* x, y pairs, e.g. &j8[0].x */
+   const GLfloat *eyeJitter; /* may be jitter, as accPerspective() callers do */
+   int stride; /* GLfloats between samples, 2 for jitter.h tables */
+   int count;
+   GLdouble *projection;
+   GLdouble *modelview;
+   int capacity;
+} accMatrixCache;
+
+/* accMatrixCacheUpdate()
+ *
+ * Rebuilds the matrices if any argument differs from the last call. The
+ * jitter tables are compared by address. Returns 1 if rebuilt, 0 if the
+ * cache was current, -1 if out of memory.
+ */
+extern int accMatrixCacheUpdate(accMatrixCache *cache, GLdouble fovy,
+   GLdouble aspect, GLdouble near, GLdouble far, GLdouble focus,
+   const GLint viewport[4], const GLfloat *jitter, const GLfloat *eyeJitter,
+   int stride, int count, GLdouble pixScale, GLdouble eyeScale);
+
+/* Loads sample's projection and modelview, leaves GL_MODELVIEW current */
+extern void accMatrixCacheLoad(const accMatrixCache *cache, int sample);
+
+extern void accMatrixCacheFree(accMatrixCache *cache);
+
 #endif /* SUBPROJECTS_REDBOOK_ACCPERSP_H_ */
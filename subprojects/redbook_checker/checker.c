@@ -51,6 +51,15 @@
 #include "checker.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKER_X86 1
+#include <immintrin.h>
+#endif
 
 /*	Create checkerboard texture	*/
 #define	checkImageWidth 64
@@ -61,6 +70,172 @@ static GLubyte checkImage[checkImageHeight][checkImageWidth][4];
 static GLuint texName;
 #endif
 
+/* Images this wide or tall are generated by several threads */
+#define CHECK_IMAGE_THREADED 8192
+#define CHECK_IMAGE_MAX_THREADS 16
+
+struct checkRows {
+   GLubyte *image;
+   const GLubyte *pattern[2]; /* rows for even and odd bands of checks */
+   size_t rowBytes;
+   int checkSize;
+   int first;
+   int last;
+};
+
+/* Plain stores, for the head and tail of a row and non x86 builds */
+static void copyRowScalar(GLubyte *dst, const GLubyte *src, size_t bytes)
+{
+   memcpy(dst, src, bytes);
+}
+
+#ifdef CHECKER_X86
+/*
+ * Streaming stores skip reading the destination into the cache, which is
+ * most of the cost for images far larger than the cache. dst is aligned
+ * first, src is loaded unaligned from the same offset.
+ */
+static void copyRowSse2(GLubyte *dst, const GLubyte *src, size_t bytes)
+{
+   size_t head = (16 - ((uintptr_t) dst & 15)) & 15;
+   if (head > bytes)
+      head = bytes;
+   copyRowScalar(dst, src, head);
+
+   size_t i = head;
+   for (; i + 16 <= bytes; i += 16)
+      _mm_stream_si128((__m128i *) (dst + i),
+		       _mm_loadu_si128((const __m128i *) (src + i)));
+   copyRowScalar(dst + i, src + i, bytes - i);
+}
+
+__attribute__((target("avx2")))
+static void copyRowAvx2(GLubyte *dst, const GLubyte *src, size_t bytes)
+{
+   size_t head = (32 - ((uintptr_t) dst & 31)) & 31;
+   if (head > bytes)
+      head = bytes;
+   copyRowScalar(dst, src, head);
+
+   size_t i = head;
+   for (; i + 32 <= bytes; i += 32)
+      _mm256_stream_si256((__m256i *) (dst + i),
+			  _mm256_loadu_si256((const __m256i *) (src + i)));
+   copyRowScalar(dst + i, src + i, bytes - i);
+}
+#endif
+
+typedef void (*copyRowFn)(GLubyte *, const GLubyte *, size_t);
+
+static copyRowFn pickCopyRow(size_t rowBytes)
+{
+#ifdef CHECKER_X86
+   /* Short rows stay in cache anyway, streaming would only hurt */
+   if (rowBytes < 4096)
+      return copyRowScalar;
+
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return copyRowAvx2;
+   if (__builtin_cpu_supports("sse2"))
+      return copyRowSse2;
+#endif
+   return copyRowScalar;
+}
+
+static void *fillRows(void *arg)
+{
+   struct checkRows *rows = arg;
+   copyRowFn copyRow = pickCopyRow(rows->rowBytes);
+
+   for (int i = rows->first; i < rows->last; i++)
+      copyRow(rows->image + (size_t) i * rows->rowBytes,
+	      rows->pattern[(i / rows->checkSize) & 1], rows->rowBytes);
+
+#ifdef CHECKER_X86
+   /* Streamed stores must be visible before another thread reads them */
+   _mm_sfence();
+#endif
+   return NULL;
+}
+
+/* Row where texel j is white when band is odd xor (j / checkSize) is odd */
+static void buildRow(GLubyte *row, int width, int checkSize, int band,
+		     enum CheckImageFormat format)
+{
+   for (int j = 0; j < width; j++) {
+      GLubyte c = (band ^ ((j / checkSize) & 1)) ? 255 : 0;
+      if (format == CHECK_IMAGE_L8) {
+	 row[j] = c;
+      } else {
+	 row[j * 4 + 0] = c;
+	 row[j * 4 + 1] = c;
+	 row[j * 4 + 2] = c;
+	 row[j * 4 + 3] = 255;
+      }
+   }
+}
+
+int makeCheckImageEx(GLubyte *image,
+		     int width,
+		     int height,
+		     int checkSize,
+		     enum CheckImageFormat format)
+{
+   if (!image || width <= 0 || height <= 0 || checkSize <= 0)
+      return -1;
+
+   size_t texelBytes = format == CHECK_IMAGE_L8 ? 1 : 4;
+   struct checkRows rows;
+   rows.image = image;
+   rows.rowBytes = (size_t) width * texelBytes;
+   rows.checkSize = checkSize;
+   rows.first = 0;
+   rows.last = height;
+
+   GLubyte *pattern = malloc(rows.rowBytes * 2);
+   if (!pattern)
+      return -1;
+   buildRow(pattern, width, checkSize, 0, format);
+   buildRow(pattern + rows.rowBytes, width, checkSize, 1, format);
+   rows.pattern[0] = pattern;
+   rows.pattern[1] = pattern + rows.rowBytes;
+
+   long cpus = 1;
+   if (width >= CHECK_IMAGE_THREADED || height >= CHECK_IMAGE_THREADED)
+      cpus = sysconf(_SC_NPROCESSORS_ONLN);
+   int threads = cpus < 1 ? 1 :
+      (cpus > CHECK_IMAGE_MAX_THREADS ? CHECK_IMAGE_MAX_THREADS : (int) cpus);
+
+   pthread_t thread[CHECK_IMAGE_MAX_THREADS];
+   struct checkRows part[CHECK_IMAGE_MAX_THREADS];
+   int started = 0;
+   for (int t = 1; t < threads; t++) {
+      part[t] = rows;
+      part[t].first = (int) ((long long) height * t / threads);
+      part[t].last = (int) ((long long) height * (t + 1) / threads);
+      if (pthread_create(&thread[t], NULL, fillRows, &part[t]) != 0)
+	 break;
+      started = t;
+   }
+
+   /* This thread takes the first share, and any share that did not start */
+   part[0] = rows;
+   part[0].last = (int) ((long long) height / threads);
+   fillRows(&part[0]);
+   if (started + 1 < threads) {
+      part[0].first = (int) ((long long) height * (started + 1) / threads);
+      part[0].last = height;
+      fillRows(&part[0]);
+   }
+
+   for (int t = 1; t <= started; t++)
+      pthread_join(thread[t], NULL);
+
+   free(pattern);
+   return 0;
+}
+
 /* Rick Ramstetter: parameterized it */
 /* void makeCheckImage(void) */
 void makeCheckImage(GLubyte *_checkImage,
@@ -81,6 +256,11 @@ void makeCheckImage(GLubyte *_checkImage,
    }
    */
 
+   /* Only falls back to the loop below if out of memory */
+   if (makeCheckImageEx(_checkImage, _checkImageWidth, _checkImageHeight,
+			8, CHECK_IMAGE_RGBA8) == 0)
+      return;
+
    for (i = 0; i < _checkImageHeight; i++) {
        for (j = 0; j < _checkImageWidth; j++) {
 	   c = ((((i&0x8)==0)^(((j&0x8))==0)))*255;
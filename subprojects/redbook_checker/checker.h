@@ -50,5 +50,24 @@ extern void makeCheckImage(GLubyte *_checkImage,
 			   int checkImageWidth,
 			   int checkImageHeight);
 
+/* Rick Ramstetter: faster generator for large textures */
+enum CheckImageFormat {
+   CHECK_IMAGE_RGBA8, /* 4 bytes per texel, alpha 255 */
+   CHECK_IMAGE_L8     /* 1 byte per texel */
+};
+
+/*
+ * Same pattern as makeCheckImage(), with checks checkSize texels wide
+ * (makeCheckImage() uses 8). Rows are tightly packed. Each row is copied
+ * from one of two prebuilt rows with wide SSE2 or AVX2 stores, and images
+ * of 8192 texels or more on a side are split across threads. Returns 0, or
+ * -1 for a bad argument or if out of memory.
+ */
+extern int makeCheckImageEx(GLubyte *image,
+			    int width,
+			    int height,
+			    int checkSize,
+			    enum CheckImageFormat format);
+
 
 #endif /* SUBPROJECTS_REDBOOK_CHECKER_H_ */
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Times makeCheckImageEx() against the original per texel loop.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "checker.h"
+
+/* The loop makeCheckImage() used before makeCheckImageEx() */
+static void originalLoop(GLubyte *image, int width, int height)
+{
+   int i, j, c, offset;
+
+   for (i = 0; i < height; i++) {
+       for (j = 0; j < width; j++) {
+	   c = ((((i&0x8)==0)^(((j&0x8))==0)))*255;
+	   offset = (i * width * 4) + (j * 4);
+	   *(image + offset + 0) = (GLubyte) c;
+	   *(image + offset + 1) = (GLubyte) c;
+	   *(image + offset + 2) = (GLubyte) c;
+	   *(image + offset + 3) = (GLubyte) 255;
+       }
+   }
+}
+
+static double nowMs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Best of reps, so page faults of the first touch are not counted */
+#define BENCH(ms, reps, call) \
+   do { \
+      ms = 1e30; \
+      for (int rep = 0; rep < (reps); rep++) { \
+	 double start = nowMs(); \
+	 call; \
+	 double elapsed = nowMs() - start; \
+	 if (elapsed < ms) \
+	    ms = elapsed; \
+      } \
+   } while (0)
+
+int main(void)
+{
+   static const int sizes[][2] = {
+      { 64, 64 }, { 512, 1024 }, { 4096, 4096 }, { 8192, 4096 }
+   };
+   int failed = 0;
+
+   printf("size,original_ms,rgba8_ms,l8_ms,speedup\n");
+   for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      int w = sizes[s][0];
+      int h = sizes[s][1];
+      size_t bytes = (size_t) w * h * 4;
+      int reps = bytes > (64 << 20) ? 3 : 10;
+      GLubyte *expect = malloc(bytes);
+      GLubyte *image = malloc(bytes);
+      if (!expect || !image) {
+	 printf("Error: cannot allocate %dx%d\n", w, h);
+	 return 1;
+      }
+
+      double original, rgba8, l8;
+      BENCH(original, reps, originalLoop(expect, w, h));
+      BENCH(rgba8, reps, makeCheckImageEx(image, w, h, 8, CHECK_IMAGE_RGBA8));
+      if (memcmp(expect, image, bytes) != 0) {
+	 printf("Error: RGBA8 output differs at %dx%d\n", w, h);
+	 failed = 1;
+      }
+
+      BENCH(l8, reps, makeCheckImageEx(image, w, h, 8, CHECK_IMAGE_L8));
+      for (size_t t = 0; t < (size_t) w * h; t++) {
+	 if (image[t] != expect[t * 4]) {
+	    printf("Error: L8 output differs at %dx%d\n", w, h);
+	    failed = 1;
+	    break;
+	 }
+      }
+
+      printf("%dx%d,%.3f,%.3f,%.3f,%.1f\n", w, h, original, rgba8, l8,
+	     original / rgba8);
+      free(expect);
+      free(image);
+   }
+   return failed;
+}
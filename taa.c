@@ -0,0 +1,316 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Temporal antialiasing, one jittered pass per frame blended with history.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <stdio.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "glcaps.h"
+#include "globjects.h"
+#include "taa.h"
+
+/*
+ * Each frame is rendered into scene (RGBA8 + depth) and its per pixel
+ * motion into motion (RGBA16F, same depth). The resolve reads the previous
+ * result from history[current] and writes the new one to the other
+ * history texture, which is then blitted to the back buffer.
+ */
+struct TaaTargets
+{
+	GLuint enabled;
+	GLuint width;
+	GLuint height;
+	GLuint sceneFbo;
+	GLuint sceneColor; /* texture */
+	GLuint depth; /* renderbuffer, shared by sceneFbo and motionFbo */
+	GLuint motionFbo;
+	GLuint motionColor; /* float texture */
+	GLuint historyFbo[2];
+	GLuint history[2]; /* float textures */
+	GLuint current; /* index of the last resolved history */
+	GLuint valid; /* 0 until a frame has been resolved since TaaReset() */
+	GLuint program;
+	GLint texel; /* uniform locations */
+	GLint blend;
+};
+
+static struct TaaTargets g_taa;
+
+static const char* g_resolveShader =
+	"#version 120\n"
+	"uniform sampler2D scene;\n"
+	"uniform sampler2D history;\n"
+	"uniform sampler2D motion;\n"
+	"uniform vec2 texel;\n"
+	"uniform float blend;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_TexCoord[0].xy;\n"
+	"	vec3 color = texture2D(scene, uv).rgb;\n"
+	"	vec3 lo = color;\n"
+	"	vec3 hi = color;\n"
+	"	for (int y = -1; y <= 1; ++y)\n"
+	"	{\n"
+	"		for (int x = -1; x <= 1; ++x)\n"
+	"		{\n"
+	"			vec3 s = texture2D(scene, uv + vec2(x, y) * texel).rgb;\n"
+	"			lo = min(lo, s);\n"
+	"			hi = max(hi, s);\n"
+	"		}\n"
+	"	}\n"
+	"	vec2 previous = uv - texture2D(motion, uv).xy;\n"
+	"	float weight = blend;\n"
+	"	if (any(lessThan(previous, vec2(0.0))) ||\n"
+	"		any(greaterThan(previous, vec2(1.0))))\n"
+	"		weight = 1.0;\n"
+	"	vec3 past = clamp(texture2D(history, previous).rgb, lo, hi);\n"
+	"	gl_FragColor = vec4(mix(past, color, weight), 1.0);\n"
+	"}\n";
+
+static int Supported()
+{
+	if (!GLVersionAtLeast(2, 0))
+		return 0;
+	if (GLVersionAtLeast(3, 0))
+		return 1;
+	return GLHasExtension("GL_ARB_framebuffer_object") &&
+			GLHasExtension("GL_ARB_texture_float");
+}
+
+static void DeleteTargets()
+{
+	if (g_taa.sceneFbo)
+		glDeleteFramebuffers(1, &g_taa.sceneFbo);
+	if (g_taa.motionFbo)
+		glDeleteFramebuffers(1, &g_taa.motionFbo);
+	if (g_taa.historyFbo[0])
+		glDeleteFramebuffers(2, g_taa.historyFbo);
+	if (g_taa.depth)
+		glDeleteRenderbuffers(1, &g_taa.depth);
+	if (g_taa.sceneColor)
+		glDeleteTextures(1, &g_taa.sceneColor);
+	if (g_taa.motionColor)
+		glDeleteTextures(1, &g_taa.motionColor);
+	if (g_taa.history[0])
+		glDeleteTextures(2, g_taa.history);
+	if (g_taa.program)
+		glDeleteProgram(g_taa.program);
+
+	g_taa.sceneFbo = 0;
+	g_taa.motionFbo = 0;
+	g_taa.historyFbo[0] = g_taa.historyFbo[1] = 0;
+	g_taa.depth = 0;
+	g_taa.sceneColor = 0;
+	g_taa.motionColor = 0;
+	g_taa.history[0] = g_taa.history[1] = 0;
+	g_taa.program = 0;
+	g_taa.enabled = 0;
+	g_taa.valid = 0;
+}
+
+/* Returns 0 on success, -1 if the resolve shader does not build */
+static int CreateProgram()
+{
+	GLuint fs = GLCompileShader(GL_FRAGMENT_SHADER, 1, &g_resolveShader, "TAA");
+	g_taa.program = GLLinkProgram(&fs, 1, 0, 0, "TAA");
+	if (!g_taa.program)
+		return -1;
+
+	glUseProgram(g_taa.program);
+	glUniform1i(glGetUniformLocation(g_taa.program, "scene"), 0);
+	glUniform1i(glGetUniformLocation(g_taa.program, "history"), 1);
+	glUniform1i(glGetUniformLocation(g_taa.program, "motion"), 2);
+	g_taa.texel = glGetUniformLocation(g_taa.program, "texel");
+	g_taa.blend = glGetUniformLocation(g_taa.program, "blend");
+	glUseProgram(0);
+	return 0;
+}
+
+/* Returns 0 on success, -1 if a framebuffer is incomplete */
+static int CreateTargets()
+{
+	GLint oldTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexture);
+	GLint oldFbo = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oldFbo);
+
+	g_taa.sceneColor = GLCreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+			g_taa.width, g_taa.height, GL_NEAREST);
+	g_taa.motionColor = GLCreateTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT,
+			g_taa.width, g_taa.height, GL_NEAREST);
+	/* History is sampled between texels wherever things moved */
+	for (int i = 0; i < 2; ++i)
+		g_taa.history[i] = GLCreateTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT,
+				g_taa.width, g_taa.height, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, oldTexture);
+
+	glGenRenderbuffers(1, &g_taa.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, g_taa.depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
+			g_taa.width, g_taa.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLenum status[4];
+	g_taa.sceneFbo = GLCreateFbo(g_taa.sceneColor, g_taa.depth);
+	status[0] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	g_taa.motionFbo = GLCreateFbo(g_taa.motionColor, g_taa.depth);
+	status[1] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	for (int i = 0; i < 2; ++i)
+	{
+		g_taa.historyFbo[i] = GLCreateFbo(g_taa.history[i], 0);
+		status[2 + i] = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, oldFbo);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (status[i] != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("Warning: TAA FBO incomplete (0x%x)\n", status[i]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+GLuint TaaConfigure(GLuint enable, GLuint width, GLuint height)
+{
+	if (!enable)
+	{
+		if (g_taa.enabled)
+			DeleteTargets();
+		return 0;
+	}
+
+	if (g_taa.enabled && width == g_taa.width && height == g_taa.height)
+		return 1;
+
+	DeleteTargets();
+	g_taa.width = width;
+	g_taa.height = height;
+
+	if (!Supported())
+	{
+		printf("Warning: TAA needs float FBOs and GLSL\n");
+		return 0;
+	}
+
+	if (CreateTargets() || CreateProgram())
+	{
+		DeleteTargets();
+		return 0;
+	}
+
+	g_taa.enabled = 1;
+	return 1;
+}
+
+void TaaBegin()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, g_taa.sceneFbo);
+}
+
+void TaaBeginMotion()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, g_taa.motionFbo);
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+			GL_POLYGON_BIT);
+
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	/* Pulled forward so the scene's own depth does not hide it */
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(-1.0, -1.0);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_BLEND);
+}
+
+void TaaEndMotion()
+{
+	glPopAttrib();
+}
+
+void TaaResolve(GLfloat blend)
+{
+	GLuint next = g_taa.current ^ 1;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, g_taa.historyFbo[next]);
+	glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_TRANSFORM_BIT);
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, g_taa.motionColor);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, g_taa.history[g_taa.current]);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, g_taa.sceneColor);
+
+	glUseProgram(g_taa.program);
+	glUniform2f(g_taa.texel, 1.0f / g_taa.width, 1.0f / g_taa.height);
+	glUniform1f(g_taa.blend, g_taa.valid ? blend : 1.0f);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0, 0.0); glVertex2f(-1.0, -1.0);
+	glTexCoord2f(1.0, 0.0); glVertex2f(1.0, -1.0);
+	glTexCoord2f(1.0, 1.0); glVertex2f(1.0, 1.0);
+	glTexCoord2f(0.0, 1.0); glVertex2f(-1.0, 1.0);
+	glEnd();
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+
+	glUseProgram(0);
+	glPopAttrib();
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, g_taa.historyFbo[next]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, g_taa.width, g_taa.height,
+			0, 0, g_taa.width, g_taa.height,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	g_taa.current = next;
+	g_taa.valid = 1;
+}
+
+void TaaReset()
+{
+	g_taa.valid = 0;
+}
+
+void TaaCleanup()
+{
+	DeleteTargets();
+	g_taa.width = 0;
+	g_taa.height = 0;
+}
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Temporal antialiasing, one jittered pass per frame blended with history.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef TAA_H_
+#define TAA_H_
+
+#include <GL/gl.h>
+
+/*
+ * (Re)creates the scene, motion and history targets if TAA was just
+ * enabled or the size changed, which also drops the history. Returns 1 if
+ * TAA is in use, 0 if disabled or float FBOs and GLSL are not supported.
+ */
+extern GLuint TaaConfigure(GLuint enable, GLuint width, GLuint height);
+
+/* Redirects rendering to the scene target, the caller clears it */
+extern void TaaBegin();
+
+/*
+ * Redirects rendering to the motion target, cleared to no motion. It shares
+ * the scene depth buffer, so only visible surfaces write motion. Draw
+ * moving objects with the same matrices as the scene pass, then call
+ * TaaEndMotion().
+ */
+extern void TaaBeginMotion();
+extern void TaaEndMotion();
+
+/*
+ * Blends the scene into the history reprojected by the motion target,
+ * clamped to the scene's 3x3 neighborhood, and writes the result to the
+ * back buffer. blend is the weight of the new frame.
+ */
+extern void TaaResolve(GLfloat blend);
+
+/* Drops the history, e.g. when the view changes */
+extern void TaaReset();
+
+extern void TaaCleanup();
+
+#endif /* TAA_H_ */
@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Work stealing thread pool for per frame parallel loops.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "threadpool.h"
+
+/* Chunks [begin, end) of loop generation still owned by one thread */
+struct Worker
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  unsigned generation; /* a late thread never takes chunks of a newer loop */
+  size_t begin;
+  size_t end;
+};
+
+static struct
+{
+  struct Worker* workers; /* workers[threads - 1] is the calling thread */
+  unsigned threads;
+  unsigned allocated; /* workers with an initialized lock */
+  pthread_mutex_t lock; /* guards generation and quit */
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned generation; /* bumped for every ThreadPoolFor() */
+  int quit;
+  atomic_size_t pending; /* chunks not finished yet */
+  ThreadPoolFn fn;
+  void* ctx;
+  size_t count;
+  size_t grain;
+} g_pool;
+
+/* Worker index + 1 on started threads, 0 on the calling thread */
+static _Thread_local unsigned g_self;
+
+static int TakeOwn(struct Worker* worker, unsigned generation, size_t* chunk)
+{
+	int found = 0;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->generation == generation && worker->begin < worker->end)
+	{
+		*chunk = worker->begin++;
+		found = 1;
+	}
+	pthread_mutex_unlock(&worker->lock);
+	return found;
+}
+
+/* Moves the back half of a victim's chunks to self, returns 0 if none left */
+static int Steal(unsigned self, unsigned generation)
+{
+	for (unsigned n = 1; n < g_pool.threads; ++n)
+	{
+		struct Worker* victim = &g_pool.workers[(self + n) % g_pool.threads];
+		size_t first = 0, last = 0;
+
+		pthread_mutex_lock(&victim->lock);
+		if (victim->generation == generation && victim->begin < victim->end)
+		{
+			last = victim->end;
+			first = last - (last - victim->begin + 1) / 2;
+			victim->end = first;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if (first < last)
+		{
+			struct Worker* worker = &g_pool.workers[self];
+			pthread_mutex_lock(&worker->lock);
+			worker->generation = generation;
+			worker->begin = first;
+			worker->end = last;
+			pthread_mutex_unlock(&worker->lock);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void RunChunks(unsigned self, unsigned generation)
+{
+	size_t chunk;
+	for (;;)
+	{
+		if (!TakeOwn(&g_pool.workers[self], generation, &chunk))
+		{
+			if (!Steal(self, generation))
+				return;
+			continue;
+		}
+
+		size_t first = chunk * g_pool.grain;
+		size_t last = first + g_pool.grain;
+		g_pool.fn(g_pool.ctx, first, last < g_pool.count ? last : g_pool.count);
+
+		if (1 == atomic_fetch_sub(&g_pool.pending, 1))
+		{
+			pthread_mutex_lock(&g_pool.lock);
+			pthread_cond_signal(&g_pool.done);
+			pthread_mutex_unlock(&g_pool.lock);
+		}
+	}
+}
+
+static void* WorkerMain(void* arg)
+{
+	unsigned self = (unsigned) (size_t) arg;
+	unsigned seen = 0;
+	g_self = self + 1;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&g_pool.lock);
+		while (seen == g_pool.generation && !g_pool.quit)
+			pthread_cond_wait(&g_pool.start, &g_pool.lock);
+		seen = g_pool.generation;
+		int quit = g_pool.quit;
+		pthread_mutex_unlock(&g_pool.lock);
+
+		if (quit)
+			return 0;
+		RunChunks(self, seen);
+	}
+}
+
+unsigned ThreadPoolInit(unsigned threads)
+{
+	ThreadPoolCleanup();
+
+	if (0 == threads)
+	{
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (unsigned) cpus : 1;
+	}
+
+	g_pool.workers = calloc(threads, sizeof(struct Worker));
+	if (!g_pool.workers)
+		return 1;
+
+	pthread_mutex_init(&g_pool.lock, 0);
+	pthread_cond_init(&g_pool.start, 0);
+	pthread_cond_init(&g_pool.done, 0);
+	for (unsigned i = 0; i < threads; ++i)
+		pthread_mutex_init(&g_pool.workers[i].lock, 0);
+	g_pool.allocated = threads;
+
+	/* The caller is the worker after the started ones */
+	g_pool.threads = 1;
+	for (unsigned i = 0; i + 1 < threads; ++i)
+	{
+		if (0 != pthread_create(&g_pool.workers[i].thread, 0, WorkerMain,
+				(void*) (size_t) i))
+		{
+			printf("Warning: started only %u of %u threads\n", i + 1, threads);
+			break;
+		}
+		++g_pool.threads;
+	}
+
+	return g_pool.threads;
+}
+
+unsigned ThreadPoolThreads()
+{
+	return g_pool.threads ? g_pool.threads : 1;
+}
+
+unsigned ThreadPoolSelf()
+{
+	return g_self ? g_self - 1 : ThreadPoolThreads() - 1;
+}
+
+void ThreadPoolFor(size_t count, size_t grain, ThreadPoolFn fn, void* ctx)
+{
+	if (0 == count)
+		return;
+	if (0 == grain)
+		grain = 1;
+
+	size_t chunks = (count + grain - 1) / grain;
+	if (g_pool.threads <= 1 || chunks <= 1)
+	{
+		fn(ctx, 0, count);
+		return;
+	}
+
+	/* Only this thread writes generation, workers read it under the lock */
+	unsigned generation = g_pool.generation + 1;
+
+	g_pool.fn = fn;
+	g_pool.ctx = ctx;
+	g_pool.count = count;
+	g_pool.grain = grain;
+	atomic_store(&g_pool.pending, chunks);
+
+	/* Even contiguous shares, so without stealing each thread stays local */
+	for (unsigned i = 0; i < g_pool.threads; ++i)
+	{
+		struct Worker* worker = &g_pool.workers[i];
+		pthread_mutex_lock(&worker->lock);
+		worker->generation = generation;
+		worker->begin = chunks * i / g_pool.threads;
+		worker->end = chunks * (i + 1) / g_pool.threads;
+		pthread_mutex_unlock(&worker->lock);
+	}
+
+	pthread_mutex_lock(&g_pool.lock);
+	g_pool.generation = generation;
+	pthread_cond_broadcast(&g_pool.start);
+	pthread_mutex_unlock(&g_pool.lock);
+
+	RunChunks(g_pool.threads - 1, generation);
+
+	pthread_mutex_lock(&g_pool.lock);
+	while (atomic_load(&g_pool.pending) > 0)
+		pthread_cond_wait(&g_pool.done, &g_pool.lock);
+	pthread_mutex_unlock(&g_pool.lock);
+}
+
+void ThreadPoolCleanup()
+{
+	if (!g_pool.workers)
+		return;
+
+	pthread_mutex_lock(&g_pool.lock);
+	g_pool.quit = 1;
+	pthread_cond_broadcast(&g_pool.start);
+	pthread_mutex_unlock(&g_pool.lock);
+	for (unsigned i = 0; i + 1 < g_pool.threads; ++i)
+		pthread_join(g_pool.workers[i].thread, 0);
+
+	pthread_cond_destroy(&g_pool.start);
+	pthread_cond_destroy(&g_pool.done);
+	pthread_mutex_destroy(&g_pool.lock);
+	for (unsigned i = 0; i < g_pool.allocated; ++i)
+		pthread_mutex_destroy(&g_pool.workers[i].lock);
+	free(g_pool.workers);
+
+	g_pool.workers = 0;
+	g_pool.threads = 0;
+	g_pool.allocated = 0;
+	g_pool.quit = 0;
+	g_pool.generation = 0;
+}
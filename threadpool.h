@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ * Work stealing thread pool for per frame parallel loops.
+ *
+ * Copyright 2026 J Rick Ramstetter, rick.ramstetter@gmail.com
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <stddef.h>
+
+/* Processes items [first, last), called once per chunk */
+typedef void (*ThreadPoolFn)(void* ctx, size_t first, size_t last);
+
+/*
+ * Starts threads - 1 workers, the calling thread is the last one. 0 uses
+ * one thread per online CPU, 1 runs every loop on the calling thread.
+ * Returns the thread count in use.
+ */
+extern unsigned ThreadPoolInit(unsigned threads);
+
+extern unsigned ThreadPoolThreads();
+
+/*
+ * Index of the calling thread, 0 to ThreadPoolThreads() - 1, for per thread
+ * scratch in fn. The thread that called ThreadPoolInit() is the last one.
+ */
+extern unsigned ThreadPoolSelf();
+
+/*
+ * Calls fn over [0, count) in chunks of grain items and returns once every
+ * chunk is done. Each thread starts on its own contiguous share of chunks
+ * and steals half of another thread's remainder when it runs out. Chunks
+ * run in no particular order, so fn must only touch its own items. Must
+ * not be called from fn.
+ */
+extern void ThreadPoolFor(size_t count, size_t grain, ThreadPoolFn fn,
+		void* ctx);
+
+extern void ThreadPoolCleanup();
+
+#endif /* THREADPOOL_H_ */